@@ -0,0 +1,164 @@
+/*
+ * Terminal Query Responder Latency Benchmark
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "answer.h"
+#include "c11-threads.h"
+#include "pty.h"
+
+#define ROUNDS   1000		/* answered queries per case */
+#define TIMEOUT  100		/* reply wait of a program, ms */
+
+static long long clock_ns (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+struct relay {
+	int master, answer;
+};
+
+/* output relay as term-filter has it when output is not a terminal */
+static int relay_proc (void *data)
+{
+	struct relay *o = data;
+	struct answer a;
+	struct buffer out;
+	char buf[512];
+	ssize_t n;
+
+	answer_init (&a, 24, 80);
+	buffer_init (&out);
+
+	while ((n = read (o->master, buf, sizeof (buf))) > 0) {
+		buffer_reset (&out);
+
+		if (answer_write (&a, buf, n, &out) && o->answer &&
+		    out.len > 0 && write (o->master, out.data, out.len) < 0)
+			break;
+	}
+
+	buffer_fini (&out);
+	return 0;
+}
+
+/*
+ * Program side: send query and wait for reply up to its final byte or
+ * timeout, returns time waited or -1 on failure
+ */
+static long long ask (int fd, const char *query, int end)
+{
+	struct pollfd p = { fd, POLLIN };
+	long long start = clock_ns (), left;
+	char c;
+
+	if (write (fd, query, strlen (query)) < 0)
+		return -1;
+
+	for (;;) {
+		left = TIMEOUT - (clock_ns () - start) / 1000000;
+
+		if (left <= 0 || poll (&p, 1, left) == 0)
+			break;
+
+		if (read (fd, &c, 1) != 1)
+			return -1;
+
+		if (c == end)
+			break;
+	}
+
+	return clock_ns () - start;
+}
+
+struct query {
+	const char *name, *query;
+	int end;
+};
+
+static const struct query cases[] = {
+	{ "status",  "\033[5n",  'n'  },
+	{ "cursor",  "\033[6n",  'R'  },
+	{ "da1",     "\033[c",   'c'  },
+	{ "da2",     "\033[>c",  'c'  },
+	{ "version", "\033[>q",  '\\' },
+	{ "size",    "\033[18t", 't'  },
+	{ NULL }
+};
+
+static int run (int answer, const struct query *q, int rounds, double *us)
+{
+	struct pty pty;
+	struct relay r;
+	struct termios t;
+	thrd_t relay;
+	long long total = 0, time;
+	int slave, i, ok = 1;
+
+	if (!pty_open (&pty))
+		return 0;
+
+	if ((slave = open (pty.name, O_RDWR | O_NOCTTY | O_CLOEXEC)) < 0)
+		goto no_slave;
+
+	tcgetattr (slave, &t);
+	cfmakeraw (&t);
+	tcsetattr (slave, TCSANOW, &t);
+
+	r.master = pty.master;
+	r.answer = answer;
+
+	if (thrd_create (&relay, relay_proc, &r) != thrd_success)
+		goto no_relay;
+
+	for (i = 0; ok && i < rounds; ++i)
+		if ((ok = (time = ask (slave, q->query, q->end)) >= 0))
+			total += time;
+
+	close (slave);			/* relay sees hangup */
+	thrd_join (relay, NULL);
+	pty_close (&pty);
+
+	*us = total / 1e3 / rounds;
+	return ok;
+no_relay:
+	close (slave);
+no_slave:
+	pty_close (&pty);
+	return 0;
+}
+
+int main (void)
+{
+	const struct query *q;
+	double on, off;
+
+	printf ("query,answered_us,unanswered_us,saved_us\n");
+
+	for (q = cases; q->name != NULL; ++q) {
+		if (!run (1, q, ROUNDS, &on) || !run (0, q, 1, &off)) {
+			perror ("answer-test");
+			return 1;
+		}
+
+		printf ("%s,%.0f,%.0f,%.0f\n", q->name, on, off, off - on);
+		fflush (stdout);
+	}
+
+	return 0;
+}
@@ -0,0 +1,180 @@
+/*
+ * Terminal Query Responder
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "answer.h"
+
+static void move_to (struct answer *o, int row, int col)
+{
+	o->row  = row < 0 ? 0 : row >= o->rows ? o->rows - 1 : row;
+	o->col  = col < 0 ? 0 : col >= o->cols ? o->cols - 1 : col;
+	o->wrap = 0;
+}
+
+static void linefeed (struct answer *o)
+{
+	if (o->row < o->rows - 1)
+		++o->row;
+
+	o->wrap = 0;
+}
+
+static void on_print (void *cookie, const char *text, size_t len)
+{
+	struct answer *o = cookie;
+	const unsigned char *p = (const void *) text, *end = p + len;
+
+	for (; p < end; ++p) {
+		if ((*p & 0xc0) == 0x80)	/* UTF-8 continuation */
+			continue;
+
+		if (o->wrap) {
+			o->col = 0;
+			linefeed (o);
+		}
+
+		if (o->col < o->cols - 1)
+			++o->col;
+		else
+			o->wrap = 1;
+	}
+}
+
+static void on_execute (void *cookie, int c)
+{
+	struct answer *o = cookie;
+
+	switch (c) {
+	case 010:				/* BS */
+		move_to (o, o->row, o->col - 1);
+		break;
+	case 011:				/* HT */
+		move_to (o, o->row, (o->col + 8) & ~7);
+		break;
+	case 012:				/* LF */
+	case 013:				/* VT */
+	case 014:				/* FF */
+		linefeed (o);
+		break;
+	case 015:				/* CR */
+		move_to (o, o->row, 0);
+		break;
+	}
+}
+
+static void reply (struct answer *o, const char *s)
+{
+	o->ok = o->ok && buffer_adds (o->out, s);
+}
+
+static void reply_pair (struct answer *o, const char *prefix, int a, int b,
+			int final)
+{
+	o->ok = o->ok && buffer_adds (o->out, prefix) &&
+		buffer_addu (o->out, a) && buffer_addc (o->out, ';') &&
+		buffer_addu (o->out, b) && buffer_addc (o->out, final);
+}
+
+/* returns non-zero if sequence is a query */
+static int query (struct answer *o, const struct vt_seq *s)
+{
+	int x = vt_param (s, 0, 0);
+
+	if (s->ninter != 0)
+		return 0;
+
+	switch (s->final) {
+	case 'n':
+		if (s->mark == 0 && x == 5)
+			reply (o, "\033[0n");
+		else if (s->mark == 0 && x == 6)
+			reply_pair (o, "\033[", o->row + 1, o->col + 1, 'R');
+		else if (s->mark == '?' && x == 6)
+			reply_pair (o, "\033[?", o->row + 1, o->col + 1, 'R');
+		else
+			return 0;
+
+		return 1;
+	case 'c':
+		if (x != 0)
+			return 0;
+
+		if (s->mark == 0)
+			reply (o, "\033[?62;22c");	/* VT220, ANSI color */
+		else if (s->mark == '>')
+			reply (o, "\033[>1;10;0c");
+		else
+			return 0;
+
+		return 1;
+	case 'q':
+		if (s->mark != '>' || x != 0)
+			return 0;
+
+		reply (o, "\033P>|term-filter\033\\");
+		return 1;
+	case 't':
+		if (s->mark != 0 || x != 18)
+			return 0;
+
+		reply_pair (o, "\033[8;", o->rows, o->cols, 't');
+		return 1;
+	}
+
+	return 0;
+}
+
+static void on_csi (void *cookie, const struct vt_seq *s)
+{
+	struct answer *o = cookie;
+	int n = vt_param (s, 0, 1);
+
+	if (query (o, s))
+		return;
+
+	if (s->mark != 0 || s->ninter != 0)
+		return;
+
+	switch (s->final) {
+	case 'A':  move_to (o, o->row - n, o->col);			break;
+	case 'B':  move_to (o, o->row + n, o->col);			break;
+	case 'C':  move_to (o, o->row, o->col + n);			break;
+	case 'D':  move_to (o, o->row, o->col - n);			break;
+	case 'E':  move_to (o, o->row + n, 0);				break;
+	case 'F':  move_to (o, o->row - n, 0);				break;
+	case 'G':  move_to (o, o->row, n - 1);				break;
+	case 'd':  move_to (o, n - 1, o->col);				break;
+	case 'H':
+	case 'f':  move_to (o, n - 1, vt_param (s, 1, 1) - 1);		break;
+	}
+}
+
+static const struct vt_ops answer_ops = {
+	.print		= on_print,
+	.execute	= on_execute,
+	.csi		= on_csi,
+};
+
+void answer_init (struct answer *o, int rows, int cols)
+{
+	o->rows  = rows;
+	o->cols  = cols;
+	o->row   = 0;
+	o->col   = 0;
+	o->wrap  = 0;
+	vt_parser_init (&o->parser, &answer_ops, o);
+}
+
+int answer_write (struct answer *o, const char *data, size_t len,
+		  struct buffer *out)
+{
+	o->out = out;
+	o->ok  = 1;
+
+	vt_parser_write (&o->parser, data, len);
+	return o->ok;
+}
@@ -0,0 +1,39 @@
+/*
+ * Terminal Query Responder
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef ANSWER_H
+#define ANSWER_H  1
+
+#include "buffer.h"
+#include "vt-parser.h"
+
+/*
+ * Recognizes terminal queries in program output and produces replies a
+ * terminal would send: status and cursor position reports (DSR), device
+ * attributes (DA1, DA2), version (XTVERSION) and text area size. Cursor
+ * position is tracked roughly, as if output went to terminal of given
+ * size without scrolling regions.
+ */
+struct answer {
+	int rows, cols;
+	int row, col, wrap;
+	int ok;
+	struct buffer *out;
+	struct vt_parser parser;
+};
+
+void answer_init (struct answer *o, int rows, int cols);
+
+/*
+ * Scan next chunk of program output and append replies to buffer,
+ * returns zero on out of memory
+ */
+int answer_write (struct answer *o, const char *data, size_t len,
+		  struct buffer *out);
+
+#endif  /* ANSWER_H */
@@ -0,0 +1,51 @@
+/*
+ * Growable Output Buffer
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdlib.h>
+
+#include "buffer.h"
+
+void buffer_init (struct buffer *o)
+{
+	o->data = NULL;
+	o->len  = 0;
+	o->size = 0;
+}
+
+void buffer_fini (struct buffer *o)
+{
+	free (o->data);
+}
+
+int buffer_grow (struct buffer *o, size_t len)
+{
+	size_t size = o->size > 0 ? o->size : 256;
+	char *p;
+
+	while (size - o->len < len)
+		size *= 2;
+
+	if ((p = realloc (o->data, size)) == NULL)
+		return 0;
+
+	o->data = p;
+	o->size = size;
+	return 1;
+}
+
+int buffer_addu (struct buffer *o, unsigned long x)
+{
+	char buf[24], *p = buf + sizeof (buf);
+
+	do {
+		*--p = '0' + x % 10;
+	}
+	while ((x /= 10) > 0);
+
+	return buffer_add (o, p, buf + sizeof (buf) - p);
+}
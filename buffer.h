@@ -0,0 +1,62 @@
+/*
+ * Growable Output Buffer
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef BUFFER_H
+#define BUFFER_H  1
+
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * The buffer is reused between chunks: buffer_reset drops the contents
+ * but keeps the storage, thus the steady state needs no allocations.
+ */
+struct buffer {
+	char *data;
+	size_t len, size;
+};
+
+void buffer_init (struct buffer *o);
+void buffer_fini (struct buffer *o);
+
+/* ensure that at least len more bytes fit, returns zero on failure */
+int buffer_grow (struct buffer *o, size_t len);
+
+static inline void buffer_reset (struct buffer *o)
+{
+	o->len = 0;
+}
+
+static inline int buffer_add (struct buffer *o, const void *data, size_t len)
+{
+	if (o->size - o->len < len && !buffer_grow (o, len))
+		return 0;
+
+	memcpy (o->data + o->len, data, len);
+	o->len += len;
+	return 1;
+}
+
+static inline int buffer_addc (struct buffer *o, int c)
+{
+	if (o->len == o->size && !buffer_grow (o, 1))
+		return 0;
+
+	o->data[o->len++] = c;
+	return 1;
+}
+
+static inline int buffer_adds (struct buffer *o, const char *s)
+{
+	return buffer_add (o, s, strlen (s));
+}
+
+/* append decimal representation of non-negative number */
+int buffer_addu (struct buffer *o, unsigned long x);
+
+#endif  /* BUFFER_H */
@@ -0,0 +1,106 @@
+/*
+ * C11 Atomics API
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef C11_ATOMICS_H
+#define C11_ATOMICS_H  1
+
+#if __STDC_VERSION__ >= 201112L && !defined (__STDC_NO_ATOMICS__)
+
+#include <stdatomic.h>
+
+#elif defined (__ATOMIC_SEQ_CST)
+
+/*
+ * Implementation via GCC atomic builtins (GCC 4.7, Clang 3.1)
+ *
+ * Atomic types are plain types here, thus all access to them must go
+ * through the functions below.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum memory_order {
+	memory_order_relaxed	= __ATOMIC_RELAXED,
+	memory_order_consume	= __ATOMIC_CONSUME,
+	memory_order_acquire	= __ATOMIC_ACQUIRE,
+	memory_order_release	= __ATOMIC_RELEASE,
+	memory_order_acq_rel	= __ATOMIC_ACQ_REL,
+	memory_order_seq_cst	= __ATOMIC_SEQ_CST,
+} memory_order;
+
+typedef _Bool		atomic_bool;
+typedef int		atomic_int;
+typedef unsigned	atomic_uint;
+typedef long		atomic_long;
+typedef unsigned long	atomic_ulong;
+typedef size_t		atomic_size_t;
+typedef intptr_t	atomic_intptr_t;
+typedef uintptr_t	atomic_uintptr_t;
+
+/* C11 7.17.2 Initialization */
+
+#define ATOMIC_VAR_INIT(x)	(x)
+#define atomic_init(o, x)	((void) (*(o) = (x)))
+
+/* C11 7.17.4 Fences */
+
+#define atomic_thread_fence(mo)	__atomic_thread_fence (mo)
+#define atomic_signal_fence(mo)	__atomic_signal_fence (mo)
+
+/* C11 7.17.7 Operations on atomic types */
+
+#define atomic_store_explicit(o, x, mo)	__atomic_store_n (o, x, mo)
+#define atomic_load_explicit(o, mo)	__atomic_load_n (o, mo)
+#define atomic_exchange_explicit(o, x, mo) \
+	__atomic_exchange_n (o, x, mo)
+
+#define atomic_compare_exchange_strong_explicit(o, e, x, ok, fail) \
+	__atomic_compare_exchange_n (o, e, x, 0, ok, fail)
+#define atomic_compare_exchange_weak_explicit(o, e, x, ok, fail) \
+	__atomic_compare_exchange_n (o, e, x, 1, ok, fail)
+
+#define atomic_fetch_add_explicit(o, x, mo)	__atomic_fetch_add (o, x, mo)
+#define atomic_fetch_sub_explicit(o, x, mo)	__atomic_fetch_sub (o, x, mo)
+#define atomic_fetch_or_explicit(o, x, mo)	__atomic_fetch_or  (o, x, mo)
+#define atomic_fetch_xor_explicit(o, x, mo)	__atomic_fetch_xor (o, x, mo)
+#define atomic_fetch_and_explicit(o, x, mo)	__atomic_fetch_and (o, x, mo)
+
+#define atomic_store(o, x) \
+	atomic_store_explicit (o, x, memory_order_seq_cst)
+#define atomic_load(o) \
+	atomic_load_explicit (o, memory_order_seq_cst)
+#define atomic_exchange(o, x) \
+	atomic_exchange_explicit (o, x, memory_order_seq_cst)
+
+#define atomic_compare_exchange_strong(o, e, x) \
+	atomic_compare_exchange_strong_explicit (o, e, x, \
+						 memory_order_seq_cst, \
+						 memory_order_seq_cst)
+#define atomic_compare_exchange_weak(o, e, x) \
+	atomic_compare_exchange_weak_explicit (o, e, x, \
+					       memory_order_seq_cst, \
+					       memory_order_seq_cst)
+
+#define atomic_fetch_add(o, x) \
+	atomic_fetch_add_explicit (o, x, memory_order_seq_cst)
+#define atomic_fetch_sub(o, x) \
+	atomic_fetch_sub_explicit (o, x, memory_order_seq_cst)
+#define atomic_fetch_or(o, x) \
+	atomic_fetch_or_explicit  (o, x, memory_order_seq_cst)
+#define atomic_fetch_xor(o, x) \
+	atomic_fetch_xor_explicit (o, x, memory_order_seq_cst)
+#define atomic_fetch_and(o, x) \
+	atomic_fetch_and_explicit (o, x, memory_order_seq_cst)
+
+#else
+
+#error "C11 atomics does not supported"
+
+#endif  /* no C11 atomics */
+#endif  /* C11_ATOMICS_H */
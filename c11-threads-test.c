@@ -0,0 +1,193 @@
+/*
+ * C11 Threads Futex Backend Benchmark
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* futex backend here, pthread one is called directly to compare */
+#ifndef C11_THREADS_FUTEX
+#define C11_THREADS_FUTEX  1
+#endif
+
+#include "c11-threads.h"
+
+#define MAX_THREADS  8
+#define LOCKS        2000000		/* per run, split between threads */
+#define ROUNDS       100000		/* of condition variable ping-pong */
+
+static long long clock_ns (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Lock contention: every thread increments shared counter under lock */
+
+static struct {
+	mtx_t m;
+	pthread_mutex_t p;
+	long count, each;
+} lock;
+
+static int futex_proc (void *cookie)
+{
+	long i;
+
+	for (i = 0; i < lock.each; ++i) {
+		mtx_lock (&lock.m);
+		++lock.count;
+		mtx_unlock (&lock.m);
+	}
+
+	return 0;
+}
+
+static int pthread_proc (void *cookie)
+{
+	long i;
+
+	for (i = 0; i < lock.each; ++i) {
+		pthread_mutex_lock (&lock.p);
+		++lock.count;
+		pthread_mutex_unlock (&lock.p);
+	}
+
+	return 0;
+}
+
+/* returns ns per lock, -1 on failure */
+static double run_lock (thrd_start_t fn, int threads)
+{
+	thrd_t t[MAX_THREADS];
+	long long start;
+	int i, n;
+
+	lock.count = 0;
+	lock.each  = LOCKS / threads;
+
+	start = clock_ns ();
+
+	for (n = 0; n < threads; ++n)
+		if (thrd_create (t + n, fn, NULL) != thrd_success)
+			break;
+
+	for (i = 0; i < n; ++i)
+		thrd_join (t[i], NULL);
+
+	if (n < threads || lock.count != lock.each * threads)
+		return -1;
+
+	return (double) (clock_ns () - start) / lock.count;
+}
+
+/* Wakeup latency: two threads pass turn to each other */
+
+static struct {
+	mtx_t m;
+	cnd_t c;
+	pthread_mutex_t pm;
+	pthread_cond_t pc;
+	int turn;
+} pp;
+
+static int futex_pong (void *cookie)
+{
+	int i, me = cookie != NULL;
+
+	for (i = 0; i < ROUNDS; ++i) {
+		mtx_lock (&pp.m);
+
+		while (pp.turn != me)
+			cnd_wait (&pp.c, &pp.m);
+
+		pp.turn = !me;
+		cnd_signal (&pp.c);
+		mtx_unlock (&pp.m);
+	}
+
+	return 0;
+}
+
+static int pthread_pong (void *cookie)
+{
+	int i, me = cookie != NULL;
+
+	for (i = 0; i < ROUNDS; ++i) {
+		pthread_mutex_lock (&pp.pm);
+
+		while (pp.turn != me)
+			pthread_cond_wait (&pp.pc, &pp.pm);
+
+		pp.turn = !me;
+		pthread_cond_signal (&pp.pc);
+		pthread_mutex_unlock (&pp.pm);
+	}
+
+	return 0;
+}
+
+/* returns ns per pass, -1 on failure */
+static double run_pong (thrd_start_t fn)
+{
+	thrd_t t;
+	long long start;
+
+	pp.turn = 0;
+	start = clock_ns ();
+
+	if (thrd_create (&t, fn, &pp) != thrd_success)
+		return -1;
+
+	fn (NULL);
+	thrd_join (t, NULL);
+	return (double) (clock_ns () - start) / (ROUNDS * 2);
+}
+
+int main (void)
+{
+	double f, p;
+	int n;
+
+	if (mtx_init (&lock.m, mtx_plain) != thrd_success ||
+	    mtx_init (&pp.m, mtx_plain) != thrd_success ||
+	    cnd_init (&pp.c) != thrd_success ||
+	    pthread_mutex_init (&lock.p, NULL) != 0 ||
+	    pthread_mutex_init (&pp.pm, NULL) != 0 ||
+	    pthread_cond_init (&pp.pc, NULL) != 0) {
+		perror ("c11-threads-test");
+		return 1;
+	}
+
+	printf ("size,mtx_t,%zu,pthread_mutex_t,%zu\n", sizeof (mtx_t),
+		sizeof (pthread_mutex_t));
+	printf ("size,cnd_t,%zu,pthread_cond_t,%zu\n", sizeof (cnd_t),
+		sizeof (pthread_cond_t));
+	printf ("test,threads,futex_ns,pthread_ns\n");
+
+	for (n = 1; n <= MAX_THREADS; n *= 2) {
+		if ((f = run_lock (futex_proc, n)) < 0 ||
+		    (p = run_lock (pthread_proc, n)) < 0) {
+			fprintf (stderr, "c11-threads-test: lock failed with "
+				 "%d threads\n", n);
+			return 1;
+		}
+
+		printf ("lock,%d,%.1f,%.1f\n", n, f, p);
+		fflush (stdout);
+	}
+
+	if ((f = run_pong (futex_pong)) < 0 || (p = run_pong (pthread_pong)) < 0) {
+		perror ("c11-threads-test");
+		return 1;
+	}
+
+	printf ("wakeup,2,%.1f,%.1f\n", f, p);
+	return 0;
+}
@@ -1,7 +1,7 @@
 /*
  * C11 Threads API
  *
- * Copyright (c) 2019-2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
  *
  * SPDX-License-Identifier: BSD-2-Clause
  */
@@ -9,23 +9,110 @@
 #ifndef C11_THREADS_H
 #define C11_THREADS_H  1
 
-#if __STDC_VERSION__ >= 201112L && !defined (__STDC_NO_THREADS__)
+#include <stddef.h>
+#include <time.h>
+
+/*
+ * Extension: thread creation attributes, NULL attributes and zero or
+ * NULL fields keep defaults. Name and CPU affinity (cpu_set_t) need
+ * _GNU_SOURCE. Native C11 threads take attributes on Linux only, where
+ * they are POSIX threads; elsewhere attributes are ignored with them.
+ *
+ * Define C11_THREADS_PTHREAD or C11_THREADS_FUTEX to use POSIX Threads
+ * even if native C11 threads are available.
+ */
+struct thrd_attr {
+	size_t stack_size;
+	size_t guard_size;
+	const char *name;
+	const void *cpus;
+	size_t cpus_size;
+};
+
+#if __STDC_VERSION__ >= 201112L && !defined (__STDC_NO_THREADS__) && \
+    !defined (C11_THREADS_PTHREAD) && !defined (C11_THREADS_FUTEX)
+
+#define C11_THREADS_NATIVE  1
 
 #include <threads.h>
 
+/* glibc and musl implement thrd_t as pthread_t */
+#ifdef __linux__
+#define C11_THREADS_POSIX  1
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#endif
+
 #elif _POSIX_C_SOURCE >= 200112L || _XOPEN_SOURCE >= 600
 
+#define C11_THREADS_POSIX  1
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+
+#else
+
+#error "C11 threads does not supported"
+
+#endif  /* no C11 threads */
+
+/*
+ * Extension: cnd_timedwait_ex takes timeout on the given clock, thus
+ * CLOCK_MONOTONIC deadlines are not affected by wall clock steps. Only
+ * futex backend waits on the clock itself, others convert the deadline
+ * into TIME_UTC.
+ */
+static inline void
+c11_clock_to_utc (const struct timespec *ts, clockid_t clock,
+		  struct timespec *utc)
+{
+	struct timespec now, real;
+
+	if (clock == CLOCK_REALTIME) {
+		*utc = *ts;
+		return;
+	}
+
+	clock_gettime (clock, &now);
+	clock_gettime (CLOCK_REALTIME, &real);
+
+	utc->tv_sec  = real.tv_sec  + ts->tv_sec  - now.tv_sec;
+	utc->tv_nsec = real.tv_nsec + ts->tv_nsec - now.tv_nsec;
+
+	if (utc->tv_nsec < 0) {
+		utc->tv_nsec += 1000000000;
+		--utc->tv_sec;
+	}
+	else if (utc->tv_nsec >= 1000000000) {
+		utc->tv_nsec -= 1000000000;
+		++utc->tv_sec;
+	}
+}
+
+#ifdef C11_THREADS_NATIVE
+
+static inline
+int cnd_timedwait_ex (cnd_t *restrict o, mtx_t *restrict m,
+		      const struct timespec *restrict timeout, clockid_t clock)
+{
+	struct timespec utc;
+
+	c11_clock_to_utc (timeout, clock, &utc);
+	return cnd_timedwait (o, m, &utc);
+}
+
+#else  /* not native C11 threads */
+
 /*
  * Implementation via POSIX Threads
  *
  * CFLAGS += -pthread -D_XOPEN_SOURCE=600
  */
 
-#include <errno.h>
-#include <pthread.h>
-#include <sched.h>
-#include <time.h>
-
 #if __STDC_VERSION__ < 199901L
 #define restrict
 #endif
@@ -38,15 +125,18 @@ enum thrd_status {
 	thrd_timedout	= 4,
 };
 
+typedef pthread_t	thrd_t;
+typedef pthread_key_t	tss_t;
+
+#ifndef C11_THREADS_FUTEX
+
 typedef pthread_once_t	once_flag;
 typedef pthread_cond_t	cnd_t;
 typedef pthread_mutex_t	mtx_t;
-typedef pthread_t	thrd_t;
-typedef pthread_key_t	tss_t;
 
 /* C11 7.25.2 Initialization functions */
 
-#define ONCE_FLAG_INIT  PTHREAD_ONCE_INIT;
+#define ONCE_FLAG_INIT  PTHREAD_ONCE_INIT
 
 static inline void call_once (once_flag *o, void (*fn) (void))
 {
@@ -153,6 +243,275 @@ static inline int mtx_unlock (mtx_t *o)
 	return pthread_mutex_unlock (o) == 0 ? thrd_success : thrd_error;
 }
 
+static inline
+int cnd_timedwait_ex (cnd_t *restrict o, mtx_t *restrict m,
+		      const struct timespec *restrict timeout, clockid_t clock)
+{
+	struct timespec utc;
+
+	c11_clock_to_utc (timeout, clock, &utc);
+	return cnd_timedwait (o, m, &utc);
+}
+
+#else  /* C11_THREADS_FUTEX */
+
+/*
+ * Synchronization via Linux futexes
+ *
+ * CFLAGS += -DC11_THREADS_FUTEX
+ *
+ * Lock word is a 32-bit integer: uncontended lock and unlock, signal or
+ * broadcast without waiters and completed call_once need no system call.
+ */
+
+#include <unistd.h>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#include "c11-atomics.h"
+
+typedef struct {
+	atomic_int state;
+} once_flag;
+
+typedef struct {
+	atomic_int seq, waiters;
+} cnd_t;
+
+/*
+ * state: 0 unlocked, 1 locked, 2 locked and there may be waiters
+ *
+ * Deviation: mtx_t is not a 4-byte lock. Lock word is 32-bit and it is
+ * the only field a plain mutex touches, but one type serves recursive
+ * mutexes as well, thus type, recursion depth and owner make it 24
+ * bytes on LP64, against 40 of pthread_mutex_t. cnd_t is 8 bytes and
+ * once_flag is 4.
+ */
+typedef struct {
+	atomic_int state;
+	int type;
+	unsigned count;			/* recursion depth */
+	atomic_ulong owner;		/* for recursive mutex only */
+} mtx_t;
+
+static inline
+int c11_futex_wait (atomic_int *o, int value, const struct timespec *timeout,
+		    clockid_t clock)
+{
+	int op = FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG |
+		 (clock == CLOCK_REALTIME ? FUTEX_CLOCK_REALTIME : 0);
+
+	return syscall (SYS_futex, o, op, value, timeout, NULL,
+			FUTEX_BITSET_MATCH_ANY) == 0 || errno != ETIMEDOUT;
+}
+
+static inline void c11_futex_wake (atomic_int *o, int count)
+{
+	syscall (SYS_futex, o, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, count);
+}
+
+/* C11 7.25.2 Initialization functions */
+
+#define ONCE_FLAG_INIT  { 0 }
+
+/* state: 0 not called, 1 in progress, 2 done */
+static inline void call_once (once_flag *o, void (*fn) (void))
+{
+	int c = 0;
+
+	if (atomic_load_explicit (&o->state, memory_order_acquire) == 2)
+		return;
+
+	if (atomic_compare_exchange_strong (&o->state, &c, 1)) {
+		fn ();
+		atomic_store (&o->state, 2);
+		c11_futex_wake (&o->state, INT_MAX);
+		return;
+	}
+
+	while ((c = atomic_load (&o->state)) != 2)
+		c11_futex_wait (&o->state, c, NULL, CLOCK_MONOTONIC);
+}
+
+/* C11 7.25.4 Mutex functions */
+
+enum mtx {
+	mtx_plain	= 0,
+	mtx_recursive	= 1,
+	mtx_timed	= 2,
+};
+
+static inline int mtx_init (mtx_t *o, int type)
+{
+	atomic_init (&o->state, 0);
+	o->type  = type;
+	o->count = 0;
+	atomic_init (&o->owner, 0);
+	return thrd_success;
+}
+
+static inline void mtx_destroy (mtx_t *o)
+{
+	(void) o;
+}
+
+static inline int c11_mtx_enter (mtx_t *o)
+{
+	if ((o->type & mtx_recursive) == 0 ||
+	    atomic_load_explicit (&o->owner, memory_order_relaxed) !=
+	    (unsigned long) pthread_self ())
+		return 0;
+
+	++o->count;
+	return 1;
+}
+
+static inline void c11_mtx_own (mtx_t *o)
+{
+	if ((o->type & mtx_recursive) == 0)
+		return;
+
+	atomic_store_explicit (&o->owner, (unsigned long) pthread_self (),
+			       memory_order_relaxed);
+	o->count = 1;
+}
+
+static inline int c11_mtx_acquire (mtx_t *o, const struct timespec *timeout,
+				   clockid_t clock)
+{
+	int c = 0;
+
+	if (c11_mtx_enter (o))
+		return thrd_success;
+
+	if (!atomic_compare_exchange_strong (&o->state, &c, 1)) {
+		if (c != 2)
+			c = atomic_exchange (&o->state, 2);
+
+		while (c != 0) {
+			if (!c11_futex_wait (&o->state, 2, timeout, clock))
+				return thrd_timedout;
+
+			c = atomic_exchange (&o->state, 2);
+		}
+	}
+
+	c11_mtx_own (o);
+	return thrd_success;
+}
+
+static inline int mtx_lock (mtx_t *o)
+{
+	return c11_mtx_acquire (o, NULL, CLOCK_MONOTONIC);
+}
+
+static inline
+int mtx_timedlock (mtx_t *restrict o, const struct timespec *restrict timeout)
+{
+	return c11_mtx_acquire (o, timeout, CLOCK_REALTIME);
+}
+
+static inline int mtx_trylock (mtx_t *o)
+{
+	int c = 0;
+
+	if (c11_mtx_enter (o))
+		return thrd_success;
+
+	if (!atomic_compare_exchange_strong (&o->state, &c, 1))
+		return thrd_busy;
+
+	c11_mtx_own (o);
+	return thrd_success;
+}
+
+static inline int mtx_unlock (mtx_t *o)
+{
+	if ((o->type & mtx_recursive) != 0) {
+		if (--o->count > 0)
+			return thrd_success;
+
+		atomic_store_explicit (&o->owner, 0, memory_order_relaxed);
+	}
+
+	if (atomic_fetch_sub (&o->state, 1) != 1) {
+		atomic_store (&o->state, 0);
+		c11_futex_wake (&o->state, 1);
+	}
+
+	return thrd_success;
+}
+
+/* C11 7.25.3 Condition variable functions */
+
+static inline int cnd_init (cnd_t *o)
+{
+	atomic_init (&o->seq, 0);
+	atomic_init (&o->waiters, 0);
+	return thrd_success;
+}
+
+static inline void cnd_destroy (cnd_t *o)
+{
+	(void) o;
+}
+
+static inline int c11_cnd_wake (cnd_t *o, int count)
+{
+	atomic_fetch_add (&o->seq, 1);
+
+	if (atomic_load (&o->waiters) > 0)
+		c11_futex_wake (&o->seq, count);
+
+	return thrd_success;
+}
+
+static inline int cnd_signal (cnd_t *o)
+{
+	return c11_cnd_wake (o, 1);
+}
+
+static inline int cnd_broadcast (cnd_t *o)
+{
+	return c11_cnd_wake (o, INT_MAX);
+}
+
+/*
+ * Waiter is counted before sequence is sampled, so a waker either sees
+ * the waiter or changes the sequence before it is sampled
+ */
+static inline
+int cnd_timedwait_ex (cnd_t *restrict o, mtx_t *restrict m,
+		      const struct timespec *restrict timeout, clockid_t clock)
+{
+	int seq, ok;
+
+	atomic_fetch_add (&o->waiters, 1);
+	seq = atomic_load (&o->seq);
+
+	mtx_unlock (m);
+	ok = c11_futex_wait (&o->seq, seq, timeout, clock);
+	atomic_fetch_sub (&o->waiters, 1);
+	mtx_lock (m);
+
+	return ok ? thrd_success : thrd_timedout;
+}
+
+static inline int cnd_wait (cnd_t *restrict o, mtx_t *restrict m)
+{
+	return cnd_timedwait_ex (o, m, NULL, CLOCK_MONOTONIC);
+}
+
+static inline
+int cnd_timedwait (cnd_t *restrict o, mtx_t *restrict m,
+		   const struct timespec *restrict timeout)
+{
+	return cnd_timedwait_ex (o, m, timeout, CLOCK_REALTIME);
+}
+
+#endif  /* C11_THREADS_FUTEX */
+
 /* C11 7.25.5 Threads functions */
 
 typedef int (*thrd_start_t) (void *cookie);
@@ -229,9 +588,68 @@ static inline int tss_set (tss_t key, void *value)
 						       thrd_error;
 }
 
-#else
+#endif  /* not native C11 threads */
 
-#error "C11 threads does not supported"
+#ifdef C11_THREADS_POSIX
 
-#endif  /* no C11 threads */
+static inline int c11_thrd_attr (pthread_attr_t *a, const struct thrd_attr *o)
+{
+	size_t stack = o->stack_size;
+
+	if (stack > 0 &&
+	    pthread_attr_setstacksize (a, stack < PTHREAD_STACK_MIN ?
+					  PTHREAD_STACK_MIN : stack) != 0)
+		return 0;
+
+	if (o->guard_size > 0 &&
+	    pthread_attr_setguardsize (a, o->guard_size) != 0)
+		return 0;
+#ifdef _GNU_SOURCE
+	if (o->cpus != NULL &&
+	    pthread_attr_setaffinity_np (a, o->cpus_size, o->cpus) != 0)
+		return 0;
+#endif
+	return 1;
+}
+
+/*
+ * Native thrd_create of glibc and musl passes start function to
+ * pthread_create the same way, and thrd_join takes int result back
+ */
+static inline int thrd_create_ex (thrd_t *o, const struct thrd_attr *attr,
+				  thrd_start_t fn, void *cookie)
+{
+	pthread_attr_t a;
+	int ret;
+
+	if (attr == NULL)
+		return thrd_create (o, fn, cookie);
+
+	if (pthread_attr_init (&a) != 0)
+		return thrd_nomem;
+
+	ret = c11_thrd_attr (&a, attr) ?
+	      pthread_create (o, &a, (void *(*) (void *)) fn, cookie) : EINVAL;
+
+	pthread_attr_destroy (&a);
+
+	if (ret != 0)
+		return ret == EAGAIN ? thrd_nomem : thrd_error;
+#ifdef _GNU_SOURCE
+	if (attr->name != NULL)
+		(void) pthread_setname_np (*o, attr->name);
+#endif
+	return thrd_success;
+}
+
+#else  /* attributes are not supported */
+
+static inline int thrd_create_ex (thrd_t *o, const struct thrd_attr *attr,
+				  thrd_start_t fn, void *cookie)
+{
+	(void) attr;
+	return thrd_create (o, fn, cookie);
+}
+
+#endif  /* C11_THREADS_POSIX */
 #endif  /* C11_THREADS_H */
@@ -0,0 +1,259 @@
+/*
+ * Lock-free Queues and Event Count Test
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <unistd.h>
+
+#include "lockfree.h"
+
+#define QUEUE_SIZE  1024
+#define ITEMS       2000000		/* per queue test */
+#define PRODUCERS   4
+#define ROUNDS      100000		/* of event count ping-pong */
+#define TIMEOUT     120			/* lost wakeup hangs, s */
+
+static long long clock_ns (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * Both sides sleep on event counts: producer when queue is full,
+ * consumer when it is empty, thus wakeups are tested too
+ */
+static struct eventcount space, data;
+
+static void put_wait (int (*push) (void *q, void *x), void *q, void *x)
+{
+	unsigned key;
+
+	while (!push (q, x)) {
+		key = eventcount_prepare (&space);
+
+		if (push (q, x)) {
+			eventcount_cancel (&space);
+			break;
+		}
+
+		eventcount_wait (&space, key);
+	}
+
+	eventcount_notify (&data);
+}
+
+static void *get_wait (void *(*pop) (void *q), void *q)
+{
+	unsigned key;
+	void *x;
+
+	while ((x = pop (q)) == NULL) {
+		key = eventcount_prepare (&data);
+
+		if ((x = pop (q)) != NULL) {
+			eventcount_cancel (&data);
+			break;
+		}
+
+		eventcount_wait (&data, key);
+	}
+
+	eventcount_notify (&space);
+	return x;
+}
+
+/* SPSC: values must come out as they went in */
+
+static struct spsc_queue sq;
+
+static int spsc_push_fn (void *q, void *x)  { return spsc_push (q, x); }
+static void *spsc_pop_fn (void *q)          { return spsc_pop (q); }
+
+static int spsc_proc (void *cookie)
+{
+	uintptr_t i;
+
+	for (i = 1; i <= ITEMS; ++i)
+		put_wait (spsc_push_fn, &sq, (void *) i);
+
+	return 0;
+}
+
+static int test_spsc (void)
+{
+	uintptr_t i, x;
+	thrd_t t;
+
+	if (thrd_create (&t, spsc_proc, NULL) != thrd_success)
+		return 0;
+
+	for (i = 1; i <= ITEMS; ++i)
+		if ((x = (uintptr_t) get_wait (spsc_pop_fn, &sq)) != i) {
+			fprintf (stderr, "lockfree-test: spsc: got %lu, "
+				 "expected %lu\n", (unsigned long) x,
+				 (unsigned long) i);
+			_exit (1);
+		}
+
+	thrd_join (t, NULL);
+	return spsc_pop (&sq) == NULL;
+}
+
+/*
+ * MPSC: every producer tags values with its number, values of each
+ * producer must come out in order, none lost or duplicated
+ */
+
+#define TAG_SHIFT  24
+
+static struct mpsc_queue mq;
+
+static int mpsc_push_fn (void *q, void *x)  { return mpsc_push (q, x); }
+static void *mpsc_pop_fn (void *q)          { return mpsc_pop (q); }
+
+static int mpsc_proc (void *cookie)
+{
+	uintptr_t tag = (uintptr_t) cookie << TAG_SHIFT, i;
+
+	for (i = 1; i <= ITEMS / PRODUCERS; ++i)
+		put_wait (mpsc_push_fn, &mq, (void *) (tag | i));
+
+	return 0;
+}
+
+static int test_mpsc (void)
+{
+	uintptr_t next[PRODUCERS], x, p, i;
+	thrd_t t[PRODUCERS];
+	int n, j;
+
+	for (n = 0; n < PRODUCERS; ++n) {
+		next[n] = 1;
+
+		if (thrd_create (t + n, mpsc_proc, (void *) (uintptr_t) n) !=
+		    thrd_success)
+			break;
+	}
+
+	for (i = 0; i < ITEMS / PRODUCERS * n; ++i) {
+		x = (uintptr_t) get_wait (mpsc_pop_fn, &mq);
+		p = x >> TAG_SHIFT;
+
+		if (p >= n || (x & ((1 << TAG_SHIFT) - 1)) != next[p]++) {
+			fprintf (stderr, "lockfree-test: mpsc: got %lu from "
+				 "producer %lu out of order\n", (unsigned long)
+				 (x & ((1 << TAG_SHIFT) - 1)), (unsigned long) p);
+			_exit (1);
+		}
+	}
+
+	for (j = 0; j < n; ++j)
+		thrd_join (t[j], NULL);
+
+	return n == PRODUCERS && mpsc_pop (&mq) == NULL;
+}
+
+/*
+ * Event count: two threads pass turn to each other, every pass needs
+ * a wakeup, a lost one hangs the test until alarm
+ */
+
+static struct eventcount ping;
+static atomic_int turn;
+
+static void pass (int me)
+{
+	unsigned key;
+
+	while (atomic_load (&turn) != me) {
+		key = eventcount_prepare (&ping);
+
+		if (atomic_load (&turn) == me) {
+			eventcount_cancel (&ping);
+			break;
+		}
+
+		eventcount_wait (&ping, key);
+	}
+
+	atomic_store (&turn, !me);
+	eventcount_notify (&ping);
+}
+
+static int pong_proc (void *cookie)
+{
+	int i;
+
+	for (i = 0; i < ROUNDS; ++i)
+		pass (1);
+
+	return 0;
+}
+
+static int test_eventcount (void)
+{
+	thrd_t t;
+	int i;
+
+	atomic_init (&turn, 0);
+
+	if (thrd_create (&t, pong_proc, NULL) != thrd_success)
+		return 0;
+
+	for (i = 0; i < ROUNDS; ++i)
+		pass (0);
+
+	thrd_join (t, NULL);
+	return atomic_load (&turn) == 0;
+}
+
+static int run (const char *name, int threads, long items, int (*fn) (void))
+{
+	long long start = clock_ns ();
+	double time;
+
+	if (!fn ()) {
+		fprintf (stderr, "lockfree-test: %s failed\n", name);
+		return 0;
+	}
+
+	time = (clock_ns () - start) / 1e9;
+	printf ("%s,%d,%ld,%.3f,%.2f\n", name, threads, items, time,
+		items / 1e6 / time);
+	fflush (stdout);
+	return 1;
+}
+
+int main (void)
+{
+	if (!spsc_init (&sq, QUEUE_SIZE) || !mpsc_init (&mq, QUEUE_SIZE) ||
+	    !eventcount_init (&space) || !eventcount_init (&data) ||
+	    !eventcount_init (&ping)) {
+		perror ("lockfree-test");
+		return 1;
+	}
+
+	alarm (TIMEOUT);
+	printf ("test,threads,items,time_s,mops\n");
+
+	if (!run ("spsc", 2, ITEMS, test_spsc) ||
+	    !run ("mpsc", PRODUCERS + 1, ITEMS, test_mpsc) ||
+	    !run ("eventcount", 2, ROUNDS * 2, test_eventcount))
+		return 1;
+
+	eventcount_fini (&ping);
+	eventcount_fini (&data);
+	eventcount_fini (&space);
+	mpsc_fini (&mq);
+	spsc_fini (&sq);
+	return 0;
+}
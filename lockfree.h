@@ -0,0 +1,255 @@
+/*
+ * Lock-free Queues and Event Count
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef LOCKFREE_H
+#define LOCKFREE_H  1
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "c11-atomics.h"
+#include "c11-threads.h"
+
+#define LF_CACHE_LINE  64
+
+/*
+ * Bounded single producer single consumer queue of pointers. Capacity
+ * must be a power of two. Push returns zero if queue is full, pop
+ * returns NULL if queue is empty, thus NULL cannot be queued. Level is
+ * the number of queued items, producer may only see it larger than it
+ * is.
+ */
+struct spsc_queue {
+	atomic_size_t head;		/* written by producer */
+	char pad_head[LF_CACHE_LINE - sizeof (atomic_size_t)];
+	atomic_size_t tail;		/* written by consumer */
+	char pad_tail[LF_CACHE_LINE - sizeof (atomic_size_t)];
+	size_t mask;
+	void **slot;
+};
+
+static inline int spsc_init (struct spsc_queue *o, size_t size)
+{
+	if ((o->slot = malloc (size * sizeof (o->slot[0]))) == NULL)
+		return 0;
+
+	atomic_init (&o->head, 0);
+	atomic_init (&o->tail, 0);
+	o->mask = size - 1;
+	return 1;
+}
+
+static inline void spsc_fini (struct spsc_queue *o)
+{
+	free (o->slot);
+}
+
+static inline int spsc_push (struct spsc_queue *o, void *x)
+{
+	size_t head = atomic_load_explicit (&o->head, memory_order_relaxed);
+	size_t tail = atomic_load_explicit (&o->tail, memory_order_acquire);
+
+	if (head - tail > o->mask)
+		return 0;
+
+	o->slot[head & o->mask] = x;
+	atomic_store_explicit (&o->head, head + 1, memory_order_release);
+	return 1;
+}
+
+static inline void *spsc_pop (struct spsc_queue *o)
+{
+	size_t tail = atomic_load_explicit (&o->tail, memory_order_relaxed);
+	size_t head = atomic_load_explicit (&o->head, memory_order_acquire);
+	void *x;
+
+	if (head == tail)
+		return NULL;
+
+	x = o->slot[tail & o->mask];
+	atomic_store_explicit (&o->tail, tail + 1, memory_order_release);
+	return x;
+}
+
+static inline size_t spsc_level (struct spsc_queue *o)
+{
+	return atomic_load_explicit (&o->head, memory_order_acquire) -
+	       atomic_load_explicit (&o->tail, memory_order_acquire);
+}
+
+/*
+ * Bounded multiple producer single consumer queue of pointers, every
+ * cell carries sequence number: it equals position when cell is free
+ * for producer, and position plus one when cell is filled for consumer.
+ * Same rules for capacity and NULL as for SPSC queue.
+ */
+struct mpsc_cell {
+	atomic_size_t seq;
+	void *data;
+};
+
+struct mpsc_queue {
+	atomic_size_t head;		/* shared by producers */
+	char pad_head[LF_CACHE_LINE - sizeof (atomic_size_t)];
+	size_t tail;			/* owned by consumer */
+	size_t mask;
+	struct mpsc_cell *cell;
+};
+
+static inline int mpsc_init (struct mpsc_queue *o, size_t size)
+{
+	size_t i;
+
+	if ((o->cell = malloc (size * sizeof (o->cell[0]))) == NULL)
+		return 0;
+
+	for (i = 0; i < size; ++i)
+		atomic_init (&o->cell[i].seq, i);
+
+	atomic_init (&o->head, 0);
+	o->tail = 0;
+	o->mask = size - 1;
+	return 1;
+}
+
+static inline void mpsc_fini (struct mpsc_queue *o)
+{
+	free (o->cell);
+}
+
+static inline int mpsc_push (struct mpsc_queue *o, void *x)
+{
+	size_t pos = atomic_load_explicit (&o->head, memory_order_relaxed);
+	struct mpsc_cell *c;
+	size_t seq;
+
+	for (;;) {
+		c   = o->cell + (pos & o->mask);
+		seq = atomic_load_explicit (&c->seq, memory_order_acquire);
+
+		if (seq == pos) {
+			if (atomic_compare_exchange_weak_explicit (
+				&o->head, &pos, pos + 1,
+				memory_order_relaxed, memory_order_relaxed))
+				break;
+		}
+		else if ((ptrdiff_t) (seq - pos) < 0)	/* not consumed: full */
+			return 0;
+		else
+			pos = atomic_load_explicit (&o->head,
+						    memory_order_relaxed);
+	}
+
+	c->data = x;
+	atomic_store_explicit (&c->seq, pos + 1, memory_order_release);
+	return 1;
+}
+
+static inline void *mpsc_pop (struct mpsc_queue *o)
+{
+	struct mpsc_cell *c = o->cell + (o->tail & o->mask);
+	void *x;
+
+	if (atomic_load_explicit (&c->seq, memory_order_acquire) !=
+	    o->tail + 1)
+		return NULL;
+
+	x = c->data;
+	atomic_store_explicit (&c->seq, o->tail + o->mask + 1,
+			       memory_order_release);
+	++o->tail;
+	return x;
+}
+
+/*
+ * Event count lets lock-free structures block: waiter takes a key with
+ * eventcount_prepare, checks its condition again and either calls
+ * eventcount_wait with the key or eventcount_cancel. Notify is cheap
+ * when nobody waits.
+ */
+struct eventcount {
+	atomic_uint epoch;
+	atomic_int waiters;
+	mtx_t lock;
+	cnd_t cond;
+};
+
+static inline int eventcount_init (struct eventcount *o)
+{
+	atomic_init (&o->epoch, 0);
+	atomic_init (&o->waiters, 0);
+
+	if (mtx_init (&o->lock, mtx_plain) != thrd_success)
+		return 0;
+
+	if (cnd_init (&o->cond) != thrd_success) {
+		mtx_destroy (&o->lock);
+		return 0;
+	}
+
+	return 1;
+}
+
+static inline void eventcount_fini (struct eventcount *o)
+{
+	cnd_destroy (&o->cond);
+	mtx_destroy (&o->lock);
+}
+
+static inline unsigned eventcount_prepare (struct eventcount *o)
+{
+	atomic_fetch_add (&o->waiters, 1);
+	return atomic_load (&o->epoch);
+}
+
+static inline void eventcount_cancel (struct eventcount *o)
+{
+	atomic_fetch_sub (&o->waiters, 1);
+}
+
+static inline void eventcount_wait (struct eventcount *o, unsigned key)
+{
+	mtx_lock (&o->lock);
+
+	while (atomic_load (&o->epoch) == key)
+		cnd_wait (&o->cond, &o->lock);
+
+	mtx_unlock (&o->lock);
+	atomic_fetch_sub (&o->waiters, 1);
+}
+
+/* wait until CLOCK_MONOTONIC deadline at most, returns zero on timeout */
+static inline int eventcount_timedwait (struct eventcount *o, unsigned key,
+					const struct timespec *deadline)
+{
+	int ok = 1;
+
+	mtx_lock (&o->lock);
+
+	while (ok && atomic_load (&o->epoch) == key)
+		ok = cnd_timedwait_ex (&o->cond, &o->lock, deadline,
+				       CLOCK_MONOTONIC) != thrd_timedout;
+
+	mtx_unlock (&o->lock);
+	atomic_fetch_sub (&o->waiters, 1);
+	return ok;
+}
+
+static inline void eventcount_notify (struct eventcount *o)
+{
+	atomic_fetch_add (&o->epoch, 1);
+
+	if (atomic_load (&o->waiters) == 0)
+		return;
+
+	mtx_lock (&o->lock);
+	cnd_broadcast (&o->cond);
+	mtx_unlock (&o->lock);
+}
+
+#endif  /* LOCKFREE_H */
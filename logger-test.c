@@ -0,0 +1,156 @@
+/*
+ * Compressed Log Ratio and Throughput Benchmark
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <sys/stat.h>
+
+#include "buffer.h"
+#include "logger.h"
+
+#define CHUNK  512		/* relay read size */
+#define MiB    (1024 * 1024)
+#define TOTAL  64		/* MiB per case */
+#define PATH   "logger-test.log"
+
+static long long clock_ns (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* build log: mostly plain text with a colored word now and then */
+static int make_build (struct buffer *b, size_t size)
+{
+	unsigned i;
+	int ok = 1;
+
+	for (i = 0; ok && b->len < size; ++i)
+		ok = buffer_adds (b, i % 16 == 0 ? "\033[32m  CC\033[0m      " :
+						 "  CC      ") &&
+		     buffer_adds (b, "drivers/net/ethernet/vendor/module-") &&
+		     buffer_addu (b, i) && buffer_adds (b, ".o\r\n");
+
+	return ok;
+}
+
+/* full screen program: redraws all rows in place, as top does */
+static int make_tui (struct buffer *b, size_t size)
+{
+	unsigned i, row;
+	int ok = 1;
+
+	for (i = 0; ok && b->len < size; ++i)
+		for (row = 1; ok && row <= 24; ++row)
+			ok = buffer_adds (b, "\033[") && buffer_addu (b, row) &&
+			     buffer_adds (b, ";1H\033[7m ") &&
+			     buffer_addu (b, 1000 + (i * 7 + row) % 9000) &&
+			     buffer_adds (b, " root  20  0  \033[0m  S  ") &&
+			     buffer_addu (b, (i + row) % 100) &&
+			     buffer_adds (b, ".0  0:00.12 process\033[K");
+
+	return ok;
+}
+
+/* binary dump: incompressible, frames are stored as is */
+static int make_noise (struct buffer *b, size_t size)
+{
+	unsigned x = 1;
+	int ok = 1;
+
+	for (; ok && b->len < size; x = x * 1103515245 + 12345)
+		ok = buffer_addc (b, x >> 16);
+
+	return ok;
+}
+
+struct input {
+	const char *name;
+	int (*make) (struct buffer *b, size_t size);
+};
+
+static const struct input cases[] = {
+	{ "build", make_build },
+	{ "tui",   make_tui },
+	{ "noise", make_noise },
+	{ NULL }
+};
+
+/* write input as relay does, time includes writer drain at close */
+static int run (int flags, const struct buffer *in, double *time,
+		double *ratio, double *zmb_s)
+{
+	size_t total = (size_t) TOTAL * MiB, pos, n;
+	struct logger log;
+	struct stat st;
+	long long start;
+
+	if (!logger_init (&log, PATH, flags))
+		return 0;
+
+	start = clock_ns ();
+
+	for (pos = 0; pos < total; pos += n) {
+		n = in->len - pos % in->len;
+		n = n < CHUNK ? n : CHUNK;
+
+		logger_write (&log, in->data + pos % in->len, n);
+	}
+
+	if (!logger_fini (&log) || stat (PATH, &st) != 0)
+		return 0;
+
+	*time  = (clock_ns () - start) / 1e9;
+	*ratio = (double) total / st.st_size;
+	*zmb_s = log.ztime > 0 ? log.in_bytes / 1e6 / log.ztime : 0;
+
+	remove (PATH);
+	return 1;
+}
+
+int main (void)
+{
+	static const char *name[] = { "plain", "lz" };
+	const struct input *c;
+	struct buffer in;
+	double time, ratio, zmb_s;
+	int i;
+
+	printf ("input,mode,mib,time_s,mb_s,ratio,compress_mb_s\n");
+
+	for (c = cases; c->name != NULL; ++c) {
+		buffer_init (&in);
+
+		if (!c->make (&in, MiB)) {
+			perror ("logger-test");
+			return 1;
+		}
+
+		for (i = 0; i < 2; ++i) {
+			if (!run (i == 0 ? 0 : LOG_COMPRESS, &in, &time, &ratio,
+				  &zmb_s)) {
+				perror ("logger-test");
+				return 1;
+			}
+
+			printf ("%s,%s,%d,%.3f,%.1f,%.2f,%.1f\n", c->name,
+				name[i], TOTAL, time,
+				TOTAL * (double) MiB / 1e6 / time, ratio,
+				zmb_s);
+			fflush (stdout);
+		}
+
+		buffer_fini (&in);
+	}
+
+	return 0;
+}
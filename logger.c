@@ -0,0 +1,280 @@
+/*
+ * Asynchronous Log Writer
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <time.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "logger.h"
+
+#define STACKSIZE  (64 * 1024)	/* writer buffers are allocated */
+
+static void log_reserve (struct logger *o, off_t end)
+{
+	if (end <= o->reserved)
+		return;
+
+	/* space is reserved beyond end of file, size set at close */
+	if (fallocate (o->fd, FALLOC_FL_KEEP_SIZE, o->reserved,
+		       LOG_PREALLOC) == 0)
+		o->reserved += LOG_PREALLOC;
+	else
+		o->reserved = end;	/* not supported, write as is */
+}
+
+static double log_clock (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* write out block past previous write */
+static int log_flush (struct logger *o)
+{
+	size_t from = o->flushed, len = o->fill;
+	ssize_t n;
+
+	if (o->flags & LOG_DIRECT) {
+		from &= ~(size_t) (LOG_ALIGN - 1);
+		len = (len + LOG_ALIGN - 1) & ~(size_t) (LOG_ALIGN - 1);
+	}
+
+	memset (o->block + o->fill, 0, len - o->fill);
+	log_reserve (o, o->offset + len);
+	o->flush_time = log_clock ();
+	len -= from;
+
+	while ((n = pwrite (o->fd, o->block + from, len,
+			    o->offset + from)) < 0 && errno == EINTR) {}
+
+	if (n != len) {
+		atomic_store (&o->ok, 0);
+		return 0;
+	}
+
+	if (o->fill == LOG_BLOCK) {
+		o->offset += LOG_BLOCK;
+		o->fill = 0;
+	}
+
+	o->flushed = o->fill;
+	return 1;
+}
+
+/* append to file stream writing out full blocks */
+static size_t log_put (struct logger *o, const void *data, size_t len)
+{
+	size_t n = LOG_BLOCK - o->fill;
+
+	n = len < n ? len : n;
+
+	memcpy (o->block + o->fill, data, n);
+	o->fill += n;
+
+	if (o->fill == LOG_BLOCK)
+		log_flush (o);
+
+	return n;
+}
+
+static void log_put_all (struct logger *o, const void *data, size_t len)
+{
+	const char *p = data;
+	size_t n;
+
+	for (; len > 0; p += n, len -= n)
+		n = log_put (o, p, len);
+}
+
+/* compress collected chunk into frame, stored as is if it does not shrink */
+static void log_pack (struct logger *o)
+{
+	uint32_t head[2] = { o->raw_fill };
+	double start = log_clock ();
+
+	head[1] = lz_compress (&o->lz, o->raw, o->raw_fill, o->zbuf,
+			       o->raw_fill - 1);
+
+	o->ztime += log_clock () - start;
+
+	if (head[1] == 0)
+		head[1] = o->raw_fill;
+
+	log_put_all (o, head, sizeof (head));
+	log_put_all (o, head[1] < o->raw_fill ? o->zbuf : o->raw, head[1]);
+
+	o->in_bytes  += o->raw_fill;
+	o->out_bytes += sizeof (head) + head[1];
+	o->raw_fill = 0;
+}
+
+/* collect chunk to compress */
+static size_t log_collect (struct logger *o, const void *data, size_t len)
+{
+	size_t n = LOG_CHUNK - o->raw_fill;
+
+	n = len < n ? len : n;
+
+	memcpy (o->raw + o->raw_fill, data, n);
+	o->raw_fill += n;
+
+	if (o->raw_fill == LOG_CHUNK)
+		log_pack (o);
+
+	return n;
+}
+
+/* ms until partial block may be written out */
+static int log_delay (struct logger *o)
+{
+	return (o->flush_time - log_clock ()) * 1000 + LOG_PERIOD;
+}
+
+/* data is collected but not written yet */
+static int log_pending (struct logger *o)
+{
+	return o->raw_fill > 0 || o->fill != o->flushed;
+}
+
+/*
+ * Compressed log is written by chunks, to not lose ratio on many small
+ * frames when output trickles: partial chunk is packed into a frame of
+ * its own only when partial block is written out.
+ */
+static int log_proc (void *data)
+{
+	struct logger *o = data;
+	int lz = o->flags & LOG_COMPRESS, delay;
+	const char *p;
+	size_t len;
+
+	if (lz)
+		log_put_all (o, LOG_MAGIC, sizeof (LOG_MAGIC) - 1);
+
+	for (;;) {
+		if (log_pending (o) && ((delay = log_delay (o)) <= 0 ||
+					!ring_poll (&o->ring, delay))) {
+			if (o->raw_fill > 0)
+				log_pack (o);
+
+			log_flush (o);
+		}
+
+		if ((len = ring_peek (&o->ring, &p)) == 0)
+			break;
+
+		len = lz ? log_collect (o, p, len) : log_put (o, p, len);
+		ring_consume (&o->ring, len);
+
+		if (!atomic_load (&o->ok)) {
+			ring_shutdown (&o->ring);
+			return 0;
+		}
+	}
+
+	if (o->raw_fill > 0)
+		log_pack (o);
+
+	if (o->fill != o->flushed)
+		log_flush (o);
+
+	return 0;
+}
+
+int logger_init (struct logger *o, const char *path, int flags)
+{
+	struct thrd_attr a = { .stack_size = STACKSIZE, .name = "log-write" };
+	int mode = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+
+	if (flags & LOG_DIRECT)
+		mode |= O_DIRECT;
+
+	if ((o->fd = open (path, mode, 0644)) < 0)
+		return 0;
+
+	if ((errno = posix_memalign ((void **) &o->block, LOG_ALIGN,
+				     LOG_BLOCK)) != 0)
+		goto no_block;
+
+	if (!ring_init (&o->ring, LOG_RING))
+		goto no_ring;
+
+	o->raw = o->zbuf = NULL;
+
+	if ((flags & LOG_COMPRESS) &&
+	    ((o->raw  = malloc (LOG_CHUNK)) == NULL ||
+	     (o->zbuf = malloc (LOG_CHUNK)) == NULL))
+		goto no_chunk;
+
+	o->flags = flags;
+	o->fill = o->flushed = o->raw_fill = 0;
+	o->flush_time = 0;
+	o->in_bytes = o->out_bytes = 0;
+	o->ztime = 0;
+	o->offset = o->reserved = 0;
+	atomic_init (&o->ok, 1);
+	atomic_init (&o->dropped, 0);
+
+	if (thrd_create_ex (&o->writer, &a, log_proc, o) != thrd_success)
+		goto no_thread;
+
+	return 1;
+no_thread:
+no_chunk:
+	free (o->zbuf);
+	free (o->raw);
+	ring_fini (&o->ring);
+no_ring:
+	errno = ENOMEM;
+	free (o->block);
+no_block:
+	close (o->fd);
+	return 0;
+}
+
+int logger_write (struct logger *o, const void *data, size_t len)
+{
+	if (!(o->flags & LOG_DROP))
+		return ring_put (&o->ring, data, len);
+
+	if (!ring_try_put (&o->ring, data, len)) {
+		if (!atomic_load (&o->ok))
+			return 0;
+
+		atomic_fetch_add (&o->dropped, len);
+	}
+
+	return 1;
+}
+
+int logger_fini (struct logger *o)
+{
+	int ok;
+
+	ring_close (&o->ring);
+	thrd_join (o->writer, NULL);
+
+	/* drop padding of last direct write and space reserved */
+	ok = atomic_load (&o->ok) && ftruncate (o->fd, o->offset + o->fill) == 0;
+	ok = close (o->fd) == 0 && ok;
+
+	ring_fini (&o->ring);
+	free (o->zbuf);
+	free (o->raw);
+	free (o->block);
+	return ok;
+}
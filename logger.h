@@ -0,0 +1,77 @@
+/*
+ * Asynchronous Log Writer
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H  1
+
+#include <stddef.h>
+
+#include <sys/types.h>
+
+#include "c11-atomics.h"
+#include "c11-threads.h"
+#include "lz.h"
+#include "ring.h"
+
+#define LOG_RING     (4 * 1024 * 1024)	/* queue between relay and writer */
+#define LOG_BLOCK    (1024 * 1024)	/* write size */
+#define LOG_ALIGN    4096		/* O_DIRECT buffer and size alignment */
+#define LOG_PERIOD   100		/* min partial block write period, ms */
+#define LOG_PREALLOC (64 * 1024 * 1024)	/* file space reserved at once */
+#define LOG_CHUNK    (64 * 1024)	/* compression unit, LZ window */
+#define LOG_MAGIC    "TFLZ1\0\0\0"	/* compressed log header */
+
+enum log_flags {
+	LOG_DROP	= 1,	/* drop data on queue overflow, do not wait */
+	LOG_DIRECT	= 2,	/* bypass page cache */
+	LOG_COMPRESS	= 4,	/* write compressed frames */
+};
+
+/*
+ * Relay only copies data into the queue, writer thread collects it into
+ * aligned blocks and writes them into preallocated file space, thus a
+ * slow disk stalls the relay only when the queue is full, and never in
+ * drop mode. Partial block is written out when the queue runs empty, but
+ * not more often than every LOG_PERIOD: only its part past the previous
+ * write is written, from the start of aligned page for O_DIRECT. Partial
+ * compression chunk is packed at that time as well.
+ *
+ * Compressed log starts with magic followed by frames: 32-bit source
+ * and payload sizes in native byte order and payload, LZ block or
+ * source as is when sizes are equal.
+ */
+struct logger {
+	int fd, flags;
+	atomic_int ok;			/* cleared by writer on error */
+	struct ring ring;
+	char *block;
+	size_t fill, flushed;
+	double flush_time;		/* of last write, s */
+	off_t offset, reserved;
+	atomic_ulong dropped;		/* bytes */
+	char *raw, *zbuf;		/* chunk to compress and result */
+	size_t raw_fill;
+	struct lz lz;
+	unsigned long long in_bytes, out_bytes;
+	double ztime;			/* spent compressing, s */
+	thrd_t writer;
+};
+
+/* returns zero on failure with errno set */
+int logger_init (struct logger *o, const char *path, int flags);
+
+/* returns zero if log is broken, dropped data is not an error */
+int logger_write (struct logger *o, const void *data, size_t len);
+
+/*
+ * Write out queued data and close log, returns zero on failure.
+ * Compression counters stay valid after that.
+ */
+int logger_fini (struct logger *o);
+
+#endif  /* LOGGER_H */
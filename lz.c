@@ -0,0 +1,180 @@
+/*
+ * LZ77 Block Codec
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <string.h>
+
+#include "lz.h"
+
+#define LZ_MIN_MATCH  4
+#define LZ_WINDOW     65535
+#define LZ_SKIP       6		/* skip faster over data without matches */
+
+static uint32_t read32 (const unsigned char *p)
+{
+	uint32_t x;
+
+	memcpy (&x, p, sizeof (x));
+	return x;
+}
+
+static size_t lz_hash (uint32_t x)
+{
+	return (x * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* append length tail: runs of 255 and the rest */
+static unsigned char *put_len (unsigned char *op, size_t n)
+{
+	for (; n >= 255; n -= 255)
+		*op++ = 255;
+
+	*op++ = n;
+	return op;
+}
+
+/* emit sequence, returns NULL if it may not fit */
+static unsigned char *put_seq (unsigned char *op, unsigned char *oend,
+			       const unsigned char *lit, size_t nlit,
+			       size_t offset, size_t match)
+{
+	size_t m = match > 0 ? match - LZ_MIN_MATCH : 0;
+
+	/* token, tails, literals and offset */
+	if ((size_t) (oend - op) < 1 + nlit / 255 + 1 + nlit + 2 + m / 255 + 1)
+		return NULL;
+
+	*op++ = (nlit < 15 ? nlit : 15) << 4 | (m < 15 ? m : 15);
+
+	if (nlit >= 15)
+		op = put_len (op, nlit - 15);
+
+	memcpy (op, lit, nlit);
+	op += nlit;
+
+	if (match == 0)
+		return op;
+
+	*op++ = offset;
+	*op++ = offset >> 8;
+
+	if (m >= 15)
+		op = put_len (op, m - 15);
+
+	return op;
+}
+
+size_t lz_compress (struct lz *o, const void *src, size_t len,
+		    void *dst, size_t cap)
+{
+	const unsigned char *base = src, *ip = base, *anchor = base;
+	const unsigned char *end = base + len, *ref;
+	unsigned char *op = dst, *oend = op + cap;
+	size_t h, m;
+	uint32_t x;
+
+	memset (o->table, 0, sizeof (o->table));
+
+	while (end - ip >= LZ_MIN_MATCH) {
+		x = read32 (ip);
+		h = lz_hash (x);
+		ref = base + o->table[h];
+		o->table[h] = ip - base;
+
+		if (ref >= ip || ip - ref > LZ_WINDOW || read32 (ref) != x) {
+			ip += 1 + ((ip - anchor) >> LZ_SKIP);
+			continue;
+		}
+
+		for (m = LZ_MIN_MATCH; ip + m < end && ref[m] == ip[m]; ++m) {}
+
+		if ((op = put_seq (op, oend, anchor, ip - anchor, ip - ref,
+				   m)) == NULL)
+			return 0;
+
+		ip += m;
+		anchor = ip;
+	}
+
+	if ((op = put_seq (op, oend, anchor, end - anchor, 0, 0)) == NULL)
+		return 0;
+
+	return op - (unsigned char *) dst;
+}
+
+/* read length tail, returns zero on end of input */
+static int get_len (const unsigned char **ip, const unsigned char *end,
+		    size_t *n)
+{
+	unsigned c;
+
+	do {
+		if (*ip == end)
+			return 0;
+
+		c = *(*ip)++;
+		*n += c;
+	}
+	while (c == 255);
+
+	return 1;
+}
+
+size_t lz_decompress (const void *src, size_t len, void *dst, size_t cap)
+{
+	const unsigned char *ip = src, *end = ip + len, *ref;
+	unsigned char *base = dst, *op = base, *oend = op + cap;
+	size_t nlit, m, offset;
+	unsigned token;
+
+	while (ip < end) {
+		token = *ip++;
+		nlit = token >> 4;
+
+		if (nlit == 15 && !get_len (&ip, end, &nlit))
+			return 0;
+
+		if ((size_t) (end - ip) < nlit || (size_t) (oend - op) < nlit)
+			return 0;
+
+		memcpy (op, ip, nlit);
+		ip += nlit, op += nlit;
+
+		if (ip == end)
+			break;
+
+		if (end - ip < 2)
+			return 0;
+
+		offset = ip[0] | ip[1] << 8;
+		ip += 2;
+		m = token & 15;
+
+		if (m == 15 && !get_len (&ip, end, &m))
+			return 0;
+
+		m += LZ_MIN_MATCH;
+
+		if (offset == 0 || offset > (size_t) (op - base) ||
+		    (size_t) (oend - op) < m)
+			return 0;
+
+		ref = op - offset;
+
+		if (offset >= m) {
+			memcpy (op, ref, m);
+			op += m;
+			continue;
+		}
+
+		/* overlapping copy repeats last offset bytes */
+		for (; m > 0; --m)
+			*op++ = *ref++;
+	}
+
+	return op - base;
+}
@@ -0,0 +1,34 @@
+/*
+ * LZ77 Block Codec
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef LZ_H
+#define LZ_H  1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LZ_HASH_BITS  12
+
+/*
+ * LZ4-style block format: sequences of token (literal and match length
+ * nibbles), literal length tail, literals, 16-bit little-endian match
+ * offset and match length tail; last sequence has literals only. Blocks
+ * are independent, window is 64 KiB.
+ */
+struct lz {
+	uint32_t table[1 << LZ_HASH_BITS];	/* positions by hash */
+};
+
+/* returns compressed size or zero if it does not fit into cap */
+size_t lz_compress (struct lz *o, const void *src, size_t len,
+		    void *dst, size_t cap);
+
+/* returns decompressed size or zero if block is broken or too large */
+size_t lz_decompress (const void *src, size_t len, void *dst, size_t cap);
+
+#endif  /* LZ_H */
@@ -0,0 +1,156 @@
+/*
+ * Streaming Multi-Pattern Matcher Benchmark
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "buffer.h"
+#include "match.h"
+
+#define PATTERNS  1000
+#define CHUNK     4096		/* relay read size */
+#define MiB       (1024 * 1024)
+#define TOTAL     16		/* MiB per case */
+
+static long long clock_ns (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static unsigned next (unsigned *x)
+{
+	return (*x = *x * 1103515245 + 12345) >> 16;
+}
+
+/* literal token like an API key */
+static int make_literal (struct buffer *b, unsigned i)
+{
+	unsigned x = i + 1, k;
+	int ok = buffer_adds (b, "tok_");
+
+	for (k = 0; ok && k < 20; ++k)
+		ok = buffer_addc (b, "abcdefghijklmnopqrstuvwxyz0123456789"
+				     [next (&x) % 36]);
+
+	return ok;
+}
+
+/* prefix and character set run, as secret formats are described */
+static int make_set (struct buffer *b, unsigned i)
+{
+	static const char *set[] = { "[0-9]", "[A-Z0-9]", "\\w", "[a-f0-9]" };
+
+	return buffer_adds (b, "k") && buffer_addu (b, i) &&
+	       buffer_addc (b, '_') && buffer_adds (b, set[i % 4]) &&
+	       buffer_adds (b, "{16}");
+}
+
+/* build log with one of the literal tokens now and then */
+static int make_input (struct buffer *b, size_t size)
+{
+	unsigned i;
+	int ok = 1;
+
+	for (i = 0; ok && b->len < size; ++i) {
+		ok = buffer_adds (b, "  CC      drivers/net/module-") &&
+		     buffer_addu (b, i) && buffer_adds (b, ".o\r\n");
+
+		if (ok && i % 64 == 0)
+			ok = buffer_adds (b, "export TOKEN=") &&
+			     make_literal (b, i % PATTERNS) &&
+			     buffer_adds (b, "\r\n");
+	}
+
+	return ok;
+}
+
+static void count_fn (void *ctx, size_t id, size_t end)
+{
+	++*(size_t *) ctx;
+}
+
+struct bench {
+	const char *name;
+	unsigned sets;			/* of every thousand patterns */
+};
+
+static const struct bench cases[] = {
+	{ "literal", 0 },
+	{ "mixed",   10 },
+	{ "set",     1000 },
+	{ NULL }
+};
+
+static int run (const struct bench *c, const struct buffer *in)
+{
+	size_t total = (size_t) TOTAL * MiB, pos, n, hits = 0;
+	struct match m;
+	struct buffer p;
+	long long start, compiled;
+	unsigned i;
+	int ok = 1;
+
+	match_init (&m);
+	buffer_init (&p);
+	start = clock_ns ();
+
+	for (i = 0; ok && i < PATTERNS; ++i) {
+		buffer_reset (&p);
+		ok = (i * 1000 / PATTERNS < c->sets ? make_set (&p, i) :
+						      make_literal (&p, i)) &&
+		     match_add (&m, p.data, p.len);
+	}
+
+	if (!ok || !(ok = match_compile (&m)))
+		goto out;
+
+	compiled = clock_ns ();
+
+	for (pos = 0; pos < total; pos += n) {
+		n = in->len - pos % in->len;
+		n = n < CHUNK ? n : CHUNK;
+
+		match_run (&m, in->data + pos % in->len, n, count_fn, &hits);
+	}
+
+	printf ("%s,%d,%zu,%zu,%.1f,%.1f,%zu\n", c->name, PATTERNS, m.count,
+		m.nfa.words, (compiled - start) / 1e6,
+		total * 1e3 / (clock_ns () - compiled), hits);
+	fflush (stdout);
+out:
+	buffer_fini (&p);
+	match_fini (&m);
+	return ok;
+}
+
+int main (void)
+{
+	const struct bench *c;
+	struct buffer in;
+
+	buffer_init (&in);
+
+	if (!make_input (&in, MiB)) {
+		perror ("match-test");
+		return 1;
+	}
+
+	printf ("case,patterns,dfas,nfa_words,compile_ms,mb_s,matches\n");
+
+	for (c = cases; c->name != NULL; ++c)
+		if (!run (c, &in)) {
+			perror ("match-test");
+			return 1;
+		}
+
+	buffer_fini (&in);
+	return 0;
+}
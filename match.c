@@ -0,0 +1,761 @@
+/*
+ * Streaming Multi-Pattern Matcher
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "match.h"
+
+/* Byte sets */
+
+typedef unsigned char set_t[32];
+
+static int set_has (const set_t s, unsigned c)
+{
+	return s[c >> 3] >> (c & 7) & 1;
+}
+
+static void set_add (set_t s, unsigned c)
+{
+	s[c >> 3] |= 1 << (c & 7);
+}
+
+static void set_range (set_t s, unsigned from, unsigned to)
+{
+	for (; from <= to; ++from)
+		set_add (s, from);
+}
+
+static void set_class (set_t s, int c)
+{
+	switch (c) {
+	case 'd':
+		set_range (s, '0', '9');
+		break;
+	case 'w':
+		set_range (s, '0', '9');
+		set_range (s, 'A', 'Z');
+		set_range (s, 'a', 'z');
+		set_add (s, '_');
+		break;
+	case 's':
+		set_range (s, '\t', '\r');
+		set_add (s, ' ');
+		break;
+	default:
+		set_add (s, c);
+	}
+}
+
+/* Pattern parser: every pattern becomes a run of positions */
+
+struct match_pos {
+	set_t set;			/* bytes, then classes */
+	uint16_t i, len;		/* index in pattern and its length */
+	uint32_t id;			/* pattern */
+};
+
+static int parse_set (const char **p, const char *end, set_t s)
+{
+	int negate = 0, c, i;
+
+	if (*p < end && **p == '^')
+		negate = 1, ++*p;
+
+	while (*p < end && **p != ']') {
+		c = (unsigned char) *(*p)++;
+
+		if (c == '\\') {
+			if (*p == end)
+				return 0;
+
+			set_class (s, (unsigned char) *(*p)++);
+			continue;
+		}
+
+		if (end - *p >= 2 && (*p)[0] == '-' && (*p)[1] != ']') {
+			set_range (s, c, (unsigned char) (*p)[1]);
+			*p += 2;
+		}
+		else
+			set_add (s, c);
+	}
+
+	if (*p == end)
+		return 0;
+
+	++*p;
+
+	if (negate)
+		for (i = 0; i < sizeof (set_t); ++i)
+			s[i] = ~s[i];
+
+	return 1;
+}
+
+static int parse_atom (const char **p, const char *end, set_t s)
+{
+	int c = (unsigned char) *(*p)++;
+
+	memset (s, 0, sizeof (set_t));
+
+	switch (c) {
+	case '\\':
+		if (*p == end)
+			return 0;
+
+		set_class (s, (unsigned char) *(*p)++);
+		return 1;
+	case '.':
+		set_range (s, 0, 255);
+		s['\n' >> 3] &= ~(1 << ('\n' & 7));
+		s['\r' >> 3] &= ~(1 << ('\r' & 7));
+		return 1;
+	case '[':
+		return parse_set (p, end, s);
+	default:
+		set_add (s, c);
+		return 1;
+	}
+}
+
+static int parse_count (const char **p, const char *end)
+{
+	int n = 0;
+
+	if (*p == end || **p != '{')
+		return 1;
+
+	for (++*p; *p < end && **p >= '0' && **p <= '9'; ++*p)
+		if ((n = n * 10 + **p - '0') > MATCH_LEN)
+			return 0;
+
+	if (*p == end || **p != '}')
+		return 0;
+
+	++*p;
+	return n;
+}
+
+static int resize (void **p, size_t count, size_t item)
+{
+	void *q;
+
+	if ((q = realloc (*p, count * item)) == NULL)
+		return 0;
+
+	*p = q;
+	return 1;
+}
+
+static int add_pos (struct match *o, const set_t s)
+{
+	size_t size;
+
+	if (o->npos == o->size) {
+		size = o->size * 2 + 256;
+
+		if (!resize ((void **) &o->pos, size, sizeof (o->pos[0])))
+			return 0;
+
+		o->size = size;
+	}
+
+	memcpy (o->pos[o->npos++].set, s, sizeof (set_t));
+	return 1;
+}
+
+void match_init (struct match *o)
+{
+	memset (o, 0, sizeof (*o));
+}
+
+void match_fini (struct match *o)
+{
+	size_t i;
+
+	for (i = 0; i < o->count; ++i) {
+		free (o->dfa[i].next);
+		free (o->dfa[i].match);
+		free (o->dfa[i].depth);
+	}
+
+	free (o->dfa);
+	free (o->nfa.mask);
+	free (o->nfa.start);
+	free (o->nfa.index);
+	free (o->nfa.id);
+	free (o->nfa.first);
+	free (o->len);
+	free (o->pos);
+}
+
+int match_add (struct match *o, const char *p, size_t len)
+{
+	const char *end = p + len;
+	size_t first = o->npos, i;
+	set_t s;
+	int n;
+
+	if (!resize ((void **) &o->len, o->patterns + 1, sizeof (o->len[0])))
+		return 0;
+
+	while (p < end) {
+		if (!parse_atom (&p, end, s) || (n = parse_count (&p, end)) == 0)
+			goto wrong;
+
+		while (n-- > 0)
+			if (o->npos - first == MATCH_LEN)
+				goto wrong;
+			else if (!add_pos (o, s))
+				goto error;
+	}
+
+	if (o->npos == first)
+		goto wrong;
+
+	for (i = first; i < o->npos; ++i) {
+		o->pos[i].i   = i - first;
+		o->pos[i].len = o->npos - first;
+		o->pos[i].id  = o->patterns;
+	}
+
+	o->len[o->patterns++] = o->npos - first;
+	return 1;
+wrong:
+	errno = EINVAL;
+error:
+	o->npos = first;
+	return 0;
+}
+
+/* Byte classes: bytes that no position tells apart share a class */
+
+static void make_classes (struct match *o)
+{
+	int key[512], b, n;
+	unsigned char cls[256];
+	size_t i;
+	set_t s;
+
+	memset (o->cls, 0, sizeof (o->cls));
+	o->nclass = 1;
+
+	for (i = 0; i < o->npos && o->nclass < 256; ++i) {
+		memset (key, -1, sizeof (key[0]) * o->nclass * 2);
+
+		for (b = 0, n = 0; b < 256; ++b) {
+			int *k = key + o->cls[b] * 2 + set_has (o->pos[i].set, b);
+
+			cls[b] = *k < 0 ? (*k = n++) : *k;
+		}
+
+		memcpy (o->cls, cls, sizeof (cls));
+		o->nclass = n;
+	}
+
+	for (i = 0; i < o->npos; ++i) {
+		memset (s, 0, sizeof (s));
+
+		for (b = 0; b < 256; ++b)
+			if (set_has (o->pos[i].set, b))
+				set_add (s, o->cls[b]);
+
+		memcpy (o->pos[i].set, s, sizeof (s));
+	}
+}
+
+/*
+ * Literal patterns go first: together they make Aho-Corasick automaton
+ * no larger than their trie. DFA for a pattern with sets may grow
+ * exponentially as the pattern can start again inside itself, thus such
+ * patterns are matched by NFA.
+ */
+static int is_literal (const struct match_pos *p)
+{
+	size_t i, k, n;
+
+	for (i = 0; i < p->len; ++i) {
+		for (k = 0, n = 0; k < sizeof (set_t); ++k)
+			n += __builtin_popcount (p[i].set[k]);
+
+		if (n != 1)
+			return 0;
+	}
+
+	return 1;
+}
+
+static int sort_patterns (struct match *o, size_t *lit)
+{
+	struct match_pos *tmp, *p;
+	size_t i, n, other;
+
+	if ((tmp = malloc (o->npos * sizeof (tmp[0]) + 1)) == NULL)
+		return 0;
+
+	for (i = 0, *lit = 0; i < o->npos; i += o->pos[i].len)
+		if (is_literal (o->pos + i))
+			*lit += o->pos[i].len;
+
+	for (i = 0, n = 0, other = *lit; i < o->npos; i += p->len) {
+		p = o->pos + i;
+
+		if (is_literal (p)) {
+			memcpy (tmp + n, p, p->len * sizeof (tmp[0]));
+			n += p->len;
+		}
+		else {
+			memcpy (tmp + other, p, p->len * sizeof (tmp[0]));
+			other += p->len;
+		}
+	}
+
+	free (o->pos);
+	o->pos  = tmp;
+	o->size = o->npos;
+	return 1;
+}
+
+/*
+ * Subset construction. DFA state is the sorted list of positions to be
+ * matched next by live partial matches (all patterns are implicitly
+ * started at every byte), plus the pattern completed on entering the
+ * state.
+ */
+struct builder {
+	const struct match_pos *pos;
+	size_t count, nclass;
+	struct match_dfa *d;
+	uint32_t *items, *off;		/* state lists */
+	size_t nitems, isize, ssize;
+	uint32_t *hash;			/* state ids plus one */
+	size_t hsize;
+	uint32_t *start, *start_off;	/* start positions by class */
+};
+
+static uint32_t list_hash (const uint32_t *p, size_t len, uint32_t m)
+{
+	uint32_t h = 2166136261u ^ m;
+
+	for (; len > 0; --len, ++p)
+		h = (h ^ *p) * 16777619u;
+
+	return h;
+}
+
+static int same_state (struct builder *b, uint32_t id, const uint32_t *p,
+		       size_t len, uint32_t m)
+{
+	return b->d->match[id] == m && b->off[id + 1] - b->off[id] == len &&
+	       (len == 0 ||
+		memcmp (b->items + b->off[id], p, len * sizeof (p[0])) == 0);
+}
+
+static int rehash (struct builder *b)
+{
+	size_t size = b->hsize * 2, i, h;
+	uint32_t *t, id;
+
+	if ((t = calloc (size, sizeof (t[0]))) == NULL)
+		return 0;
+
+	for (id = 0; id < b->d->count; ++id) {
+		h = list_hash (b->items + b->off[id], b->off[id + 1] - b->off[id],
+			       b->d->match[id]);
+
+		for (i = h & (size - 1); t[i] != 0; i = (i + 1) & (size - 1)) {}
+
+		t[i] = id + 1;
+	}
+
+	free (b->hash);
+	b->hash  = t;
+	b->hsize = size;
+	return 1;
+}
+
+/* returns state id or -1 on failure */
+static long find_state (struct builder *b, const uint32_t *p, size_t len,
+			uint32_t m)
+{
+	struct match_dfa *d = b->d;
+	uint32_t h = list_hash (p, len, m), id;
+	size_t i, k, n, depth = 0;
+
+	for (i = h & (b->hsize - 1); b->hash[i] != 0; i = (i + 1) & (b->hsize - 1))
+		if (same_state (b, b->hash[i] - 1, p, len, m))
+			return b->hash[i] - 1;
+
+	if ((id = d->count) == MATCH_STATES) {
+		errno = E2BIG;
+		return -1;
+	}
+
+	if (b->nitems + len > b->isize) {
+		n = (b->nitems + len) * 2;
+
+		if (!resize ((void **) &b->items, n, sizeof (b->items[0])))
+			return -1;
+
+		b->isize = n;
+	}
+
+	if (id == b->ssize) {
+		n = b->ssize * 2 + 64;
+
+		if (!resize ((void **) &b->off, n + 1, sizeof (b->off[0])) ||
+		    !resize ((void **) &d->match, n, sizeof (d->match[0])) ||
+		    !resize ((void **) &d->depth, n, sizeof (d->depth[0])) ||
+		    !resize ((void **) &d->next, n * b->nclass, sizeof (d->next[0])))
+			return -1;
+
+		b->off[0] = 0;
+		b->ssize = n;
+	}
+
+	if (len > 0)
+		memcpy (b->items + b->nitems, p, len * sizeof (p[0]));
+
+	b->nitems += len;
+	b->off[id + 1] = b->nitems;
+
+	for (k = 0; k < len; ++k)
+		if (b->pos[p[k]].i > depth)
+			depth = b->pos[p[k]].i;
+
+	d->match[id] = m;
+	d->depth[id] = depth;
+	b->hash[i] = id + 1;
+
+	if (++d->count * 2 > b->hsize && !rehash (b))
+		return -1;
+
+	return id;
+}
+
+static int make_starts (struct builder *b)
+{
+	size_t cl, k, n = 0;
+
+	if ((b->start_off = malloc ((b->nclass + 1) * sizeof (uint32_t))) == NULL)
+		return 0;
+
+	for (cl = 0; cl < b->nclass; ++cl)
+		for (k = 0; k < b->count; ++k)
+			n += b->pos[k].i == 0 && set_has (b->pos[k].set, cl);
+
+	if ((b->start = malloc ((n + 1) * sizeof (uint32_t))) == NULL)
+		return 0;
+
+	for (cl = 0, n = 0; cl < b->nclass; ++cl) {
+		b->start_off[cl] = n;
+
+		for (k = 0; k < b->count; ++k)
+			if (b->pos[k].i == 0 && set_has (b->pos[k].set, cl))
+				b->start[n++] = k;
+	}
+
+	b->start_off[cl] = n;
+	return 1;
+}
+
+#define MATCH_HIT  (1u << 31)		/* next state completes a pattern */
+
+/* longer pattern wins, then the one added first */
+static int better (const struct match_pos *p, const struct match_pos *q)
+{
+	return q == NULL || p->len > q->len || (p->len == q->len && p->id < q->id);
+}
+
+static int build (struct builder *b)
+{
+	struct match_dfa *d = b->d;
+	const struct match_pos *pos = b->pos, *m;
+	uint32_t *cur = NULL, *next = NULL, *from, *to;
+	size_t s, cl, len, n, i, j, size = b->count + 1;
+	long id;
+	int ok = 0;
+
+	if ((b->hash = calloc (b->hsize = 1024, sizeof (b->hash[0]))) == NULL ||
+	    (cur  = malloc (size * sizeof (cur[0])))  == NULL ||
+	    (next = malloc (size * sizeof (next[0]))) == NULL ||
+	    !make_starts (b) || find_state (b, NULL, 0, 0) != 0)
+		goto out;
+
+	for (s = 0; s < d->count; ++s) {
+		len = b->off[s + 1] - b->off[s];
+
+		if (len > 0)	/* no items are allocated for empty state */
+			memcpy (cur, b->items + b->off[s],
+				len * sizeof (cur[0]));
+
+		for (cl = 0; cl < b->nclass; ++cl) {
+			from = b->start + b->start_off[cl];
+			to   = b->start + b->start_off[cl + 1];
+			m = NULL;
+
+			/* merge advanced live positions with new starts */
+			for (i = 0, n = 0; i < len || from < to;) {
+				if (i < len && (from == to || cur[i] < *from))
+					j = cur[i++];
+				else
+					j = *from++;
+
+				if (!set_has (pos[j].set, cl))
+					continue;
+
+				if (pos[j].i + 1 < pos[j].len)
+					next[n++] = j + 1;
+				else if (better (pos + j, m))
+					m = pos + j;
+			}
+
+			id = find_state (b, next, n, m == NULL ? 0 : m->id + 1);
+
+			if (id < 0)
+				goto out;
+
+			d->next[s * b->nclass + cl] = id;
+		}
+	}
+
+	/* runtime walks table rows, no multiplication per byte */
+	for (i = 0; i < d->count * b->nclass; ++i) {
+		j = d->next[i];
+		d->next[i] = j * b->nclass | (d->match[j] > 0 ? MATCH_HIT : 0);
+	}
+
+	ok = 1;
+out:
+	free (next);
+	free (cur);
+	free (b->start_off);
+	free (b->start);
+	free (b->hash);
+	free (b->off);
+	free (b->items);
+	return ok;
+}
+
+/* too many literals are split in two automata at pattern boundary */
+static int add_dfa (struct match *o, const struct match_pos *pos, size_t count)
+{
+	struct builder b = { .pos = pos, .count = count, .nclass = o->nclass };
+	size_t half;
+
+	if (count == 0)
+		return 1;
+
+	if (!resize ((void **) &o->dfa, o->count + 1, sizeof (o->dfa[0])))
+		return 0;
+
+	b.d = o->dfa + o->count;
+	memset (b.d, 0, sizeof (*b.d));
+	++o->count;
+
+	if (build (&b))
+		return 1;
+
+	--o->count;
+	free (b.d->next);
+	free (b.d->match);
+	free (b.d->depth);
+
+	if (errno != E2BIG || pos[0].len == count)
+		return 0;
+
+	for (half = pos[0].len; half + pos[half].len <= count / 2;
+	     half += pos[half].len) {}
+
+	return add_dfa (o, pos, half) && add_dfa (o, pos + half, count - half);
+}
+
+/*
+ * Bit-parallel (Shift-And) matcher for patterns with sets: bit per
+ * position, all patterns packed one after another.
+ */
+static int make_nfa (struct match *o, const struct match_pos *pos, size_t count)
+{
+	struct match_nfa *n = &o->nfa;
+	size_t j, cl, w;
+
+	n->words = (count + 63) / 64;
+
+	if (count == 0)
+		return 1;
+
+	if ((n->mask  = calloc (o->nclass * n->words, sizeof (uint64_t))) == NULL ||
+	    (n->start = calloc (n->words * 3, sizeof (uint64_t))) == NULL ||
+	    (n->index = malloc (count * sizeof (n->index[0]))) == NULL ||
+	    (n->id    = malloc (count * sizeof (n->id[0]))) == NULL ||
+	    (n->first = calloc (o->nclass, 1)) == NULL)
+		return 0;
+
+	n->final = n->start + n->words;
+	n->state = n->final + n->words;
+
+	for (j = 0; j < count; ++j) {
+		w = j / 64;
+
+		for (cl = 0; cl < o->nclass; ++cl)
+			if (set_has (pos[j].set, cl))
+				n->mask[cl * n->words + w] |= 1ull << (j % 64);
+
+		if (pos[j].i == 0) {
+			n->start[w] |= 1ull << (j % 64);
+
+			for (cl = 0; cl < o->nclass; ++cl)
+				n->first[cl] |= set_has (pos[j].set, cl);
+		}
+
+		if (pos[j].i + 1 == pos[j].len)
+			n->final[w] |= 1ull << (j % 64);
+
+		n->index[j] = pos[j].i;
+		n->id[j]    = pos[j].id;
+	}
+
+	return 1;
+}
+
+int match_compile (struct match *o)
+{
+	size_t lit;
+	int ok;
+
+	ok = sort_patterns (o, &lit);
+
+	if (ok) {
+		make_classes (o);
+		ok = add_dfa (o, o->pos, lit) &&
+		     make_nfa (o, o->pos + lit, o->npos - lit);
+	}
+
+	free (o->pos);
+	o->pos = NULL;
+	o->npos = o->size = 0;
+	return ok;
+}
+
+/* Runtime */
+
+static size_t dfa_run (struct match *o, struct match_dfa *d,
+		       const unsigned char *p, size_t len,
+		       match_fn *fn, void *ctx)
+{
+	uint32_t s = d->state, t;
+	size_t i;
+
+	for (i = 0; i < len; ++i) {
+		t = d->next[s + o->cls[p[i]]];
+		s = t & ~MATCH_HIT;
+
+		if (t & MATCH_HIT)
+			fn (ctx, d->match[s / o->nclass] - 1, i + 1);
+	}
+
+	d->state = s;
+	return d->depth[s / o->nclass];
+}
+
+/* best match in final bits */
+static size_t nfa_match (const struct match *o, const uint64_t *set)
+{
+	const struct match_nfa *n = &o->nfa;
+	size_t w, j, m = 0;
+	uint64_t x;
+
+	for (w = 0; w < n->words; ++w)
+		for (x = set[w]; x != 0; x &= x - 1) {
+			j = w * 64 + __builtin_ctzll (x);
+
+			if (m == 0 || o->len[n->id[j]] > o->len[m - 1] ||
+			    (o->len[n->id[j]] == o->len[m - 1] && n->id[j] < m - 1))
+				m = n->id[j] + 1;
+		}
+
+	return m - 1;
+}
+
+/* longest live prefix in other bits */
+static size_t nfa_depth (const struct match_nfa *n, const uint64_t *set)
+{
+	size_t w, j, m = 0;
+	uint64_t x;
+
+	for (w = 0; w < n->words; ++w)
+		for (x = set[w]; x != 0; x &= x - 1) {
+			j = w * 64 + __builtin_ctzll (x);
+
+			if (n->index[j] + 1u > m)
+				m = n->index[j] + 1;
+		}
+
+	return m;
+}
+
+static size_t nfa_run (struct match *o, const unsigned char *p, size_t len,
+		       match_fn *fn, void *ctx)
+{
+	struct match_nfa *n = &o->nfa;
+	const size_t W = n->words;
+	uint64_t *s = n->state, hit, carry, live = 0, x, set[W];
+	const uint64_t *mask;
+	size_t i, w, cl;
+
+	for (w = 0; w < W; ++w)
+		live |= s[w];
+
+	for (i = 0; i < len; ++i) {
+		cl = o->cls[p[i]];
+
+		/* most bytes start nothing while nothing is alive */
+		if (live == 0 && !n->first[cl])
+			continue;
+
+		mask = n->mask + cl * W;
+
+		for (w = 0, carry = 0, hit = 0, live = 0; w < W; ++w) {
+			x = s[w];
+			s[w] = ((x << 1) | carry | n->start[w]) & mask[w];
+			carry = x >> 63;
+			hit  |= s[w] & n->final[w];
+			live |= s[w];
+		}
+
+		if (hit) {
+			for (w = 0; w < W; ++w)
+				set[w] = s[w] & n->final[w];
+
+			fn (ctx, nfa_match (o, set), i + 1);
+		}
+	}
+
+	for (w = 0; w < W; ++w)
+		set[w] = s[w] & ~n->final[w];
+
+	return nfa_depth (n, set);
+}
+
+size_t match_run (struct match *o, const void *data, size_t len,
+		  match_fn *fn, void *ctx)
+{
+	size_t depth = 0, n, i;
+
+	for (i = 0; i < o->count; ++i)
+		if ((n = dfa_run (o, o->dfa + i, data, len, fn, ctx)) > depth)
+			depth = n;
+
+	if (o->nfa.words > 0 &&
+	    (n = nfa_run (o, data, len, fn, ctx)) > depth)
+		depth = n;
+
+	return depth;
+}
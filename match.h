@@ -0,0 +1,81 @@
+/*
+ * Streaming Multi-Pattern Matcher
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef MATCH_H
+#define MATCH_H  1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MATCH_LEN     256		/* max pattern length */
+#define MATCH_STATES  (1 << 16)		/* max states per automaton */
+
+/*
+ * Patterns are fixed-length: literal bytes, escapes \d \w \s and \x for
+ * literal x, any byte except line end as '.', sets like [^a-z0-9_], and
+ * repeat count like {40} after any of them.
+ *
+ * Literal patterns are compiled into DFA over byte classes, patterns
+ * with sets into bit-parallel NFA, as their DFA may grow exponentially.
+ * Both know the longest pattern completed at every byte and the length
+ * of the longest pattern prefix still alive, and carry their state from
+ * chunk to chunk, thus data is never scanned twice.
+ */
+struct match_dfa {
+	uint32_t *next;			/* by state row and class */
+	uint32_t *match;		/* pattern plus one by state */
+	uint16_t *depth;		/* by state */
+	size_t count;
+	uint32_t state;			/* row of current state */
+};
+
+struct match_nfa {
+	size_t words;			/* 64 positions per word */
+	uint64_t *mask;			/* by class and word */
+	uint64_t *start, *final, *state;
+	uint16_t *index;		/* in pattern by position */
+	uint32_t *id;			/* pattern by position */
+	unsigned char *first;		/* class starts a pattern */
+};
+
+struct match_pos;
+
+struct match {
+	unsigned char cls[256];		/* byte to class */
+	size_t nclass;
+	struct match_dfa *dfa;
+	size_t count;
+	struct match_nfa nfa;
+	uint16_t *len;			/* by pattern */
+	size_t patterns;
+	struct match_pos *pos;		/* compiler input */
+	size_t npos, size;
+};
+
+void match_init (struct match *o);
+void match_fini (struct match *o);
+
+/* returns zero on failure, errno is EINVAL for wrong pattern */
+int match_add (struct match *o, const char *pattern, size_t len);
+int match_compile (struct match *o);
+
+/*
+ * Pattern id and offset in chunk after its end. When patterns end at the
+ * same byte the longest one is reported, then the first added.
+ */
+typedef void match_fn (void *ctx, size_t id, size_t end);
+
+/*
+ * Feed next chunk, every automaton in turn reports its matches in
+ * chunk order. Returns the length of the longest pattern prefix still
+ * alive.
+ */
+size_t match_run (struct match *o, const void *data, size_t len,
+		  match_fn *fn, void *ctx);
+
+#endif  /* MATCH_H */
@@ -0,0 +1,36 @@
+/*
+ * Bracketed Paste Detector
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "paste.h"
+
+static const char marker[] = "\033[20?~";	/* ? is 0 or 1 */
+
+void paste_scan (struct paste *o, const char *data, size_t len)
+{
+	const char *end = data + len;
+	int c, pos = o->pos;
+
+	for (; data < end; ++data) {
+		c = *data;
+
+		if (pos == 4 && (c == '0' || c == '1')) {
+			o->start = c == '0';
+			++pos;
+		}
+		else if (pos != 4 && c == marker[pos]) {
+			if (++pos == sizeof (marker) - 1) {
+				o->active = o->start;
+				pos = 0;
+			}
+		}
+		else
+			pos = c == marker[0];
+	}
+
+	o->pos = pos;
+}
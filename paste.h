@@ -0,0 +1,33 @@
+/*
+ * Bracketed Paste Detector
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef PASTE_H
+#define PASTE_H  1
+
+#include <stddef.h>
+
+/*
+ * Tracks paste start (ESC [ 200 ~) and end (ESC [ 201 ~) markers in
+ * user input, markers may be split between chunks
+ */
+struct paste {
+	int pos;		/* length of matched marker prefix */
+	int start;		/* matched marker is start one */
+	int active;		/* inside of bracketed paste */
+};
+
+static inline void paste_init (struct paste *o)
+{
+	o->pos    = 0;
+	o->start  = 0;
+	o->active = 0;
+}
+
+void paste_scan (struct paste *o, const char *data, size_t len);
+
+#endif  /* PASTE_H */
@@ -0,0 +1,184 @@
+/*
+ * Work-stealing Thread Pool Scaling Benchmark
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <unistd.h>
+
+#include "pool.h"
+
+#define ITEMS  (1 << 20)	/* units of work per run */
+#define ROUNDS 200		/* of hash per unit */
+#define LEAF   256		/* units per task */
+
+static struct pool pool;
+static atomic_ulong total;
+
+static uint64_t work (uint64_t x)
+{
+	int i;
+
+	for (i = 0; i < ROUNDS; ++i)
+		x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+
+	return x;
+}
+
+static void work_range (unsigned long from, unsigned long to)
+{
+	unsigned long sum = 0;
+
+	for (; from < to; ++from)
+		sum += work (from + 1) & 0xffff;
+
+	atomic_fetch_add (&total, sum);
+}
+
+/* independent tasks submitted from outside of pool */
+struct flat {
+	struct pool_task task;		/* first: flat is found by task */
+	unsigned long from;
+};
+
+static void flat_fn (struct pool_task *t)
+{
+	struct flat *o = (void *) t;
+
+	work_range (o->from, o->from + LEAF);
+}
+
+static int run_flat (void)
+{
+	static struct flat task[ITEMS / LEAF];
+	struct pool_group g;
+	size_t i;
+
+	pool_group_init (&g);
+
+	for (i = 0; i < ITEMS / LEAF; ++i) {
+		task[i].task.fn = flat_fn;
+		task[i].from = i * LEAF;
+		pool_submit (&pool, &task[i].task, &g);
+	}
+
+	pool_wait (&pool, &g);
+	return 1;
+}
+
+/* fork-join: task splits its range in halves and waits for them */
+struct split {
+	struct pool_task task;		/* first: split is found by task */
+	unsigned long from, to;
+};
+
+static void split_fn (struct pool_task *t)
+{
+	struct split *o = (void *) t, half[2];
+	struct pool_group g;
+	unsigned long mid = o->from + (o->to - o->from) / 2;
+
+	if (o->to - o->from <= LEAF) {
+		work_range (o->from, o->to);
+		return;
+	}
+
+	pool_group_init (&g);
+
+	half[0] = (struct split) { { split_fn }, o->from, mid };
+	half[1] = (struct split) { { split_fn }, mid, o->to };
+
+	pool_submit (&pool, &half[0].task, &g);
+	pool_submit (&pool, &half[1].task, &g);
+	pool_wait (&pool, &g);
+}
+
+static int run_split (void)
+{
+	struct split root = { { split_fn }, 0, ITEMS };
+	struct pool_group g;
+
+	pool_group_init (&g);
+	pool_submit (&pool, &root.task, &g);
+	pool_wait (&pool, &g);
+	return 1;
+}
+
+static long long clock_ns (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+struct bench {
+	const char *name;
+	int (*run) (void);
+};
+
+static const struct bench cases[] = {
+	{ "flat",  run_flat },
+	{ "split", run_split },
+	{ NULL }
+};
+
+int main (int argc, char *argv[])
+{
+	const struct bench *b;
+	unsigned long expected;
+	long long start;
+	double time, base[2];
+	int max = 0, n, i;
+
+	if (argc > 2 || (argc == 2 && (max = atoi (argv[1])) <= 0)) {
+		fputs ("usage:\n\tpool-test [max-workers]\n", stderr);
+		return 1;
+	}
+
+	if (argc == 1 && (max = sysconf (_SC_NPROCESSORS_ONLN)) <= 0)
+		max = 1;
+
+	atomic_init (&total, 0);
+	work_range (0, ITEMS);
+	expected = atomic_load (&total);
+
+	printf ("test,workers,time_s,speedup\n");
+
+	for (n = 1; n <= max; n = n < max && n * 2 > max ? max : n * 2) {
+		if (!pool_init (&pool, n)) {
+			perror ("pool-test");
+			return 1;
+		}
+
+		for (b = cases, i = 0; b->name != NULL; ++b, ++i) {
+			atomic_store (&total, 0);
+			start = clock_ns ();
+			b->run ();
+			time = (clock_ns () - start) / 1e9;
+
+			if (atomic_load (&total) != expected) {
+				fprintf (stderr, "pool-test: %s with %d workers: "
+					 "tasks lost or repeated\n", b->name, n);
+				return 1;
+			}
+
+			if (n == 1)
+				base[i] = time;
+
+			printf ("%s,%d,%.3f,%.2f\n", b->name, n, time,
+				base[i] / time);
+			fflush (stdout);
+		}
+
+		pool_fini (&pool);
+	}
+
+	return 0;
+}
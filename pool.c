@@ -0,0 +1,289 @@
+/*
+ * Work-stealing Thread Pool
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdlib.h>
+
+#include <unistd.h>
+
+#include "pool.h"
+
+#define MASK  (POOL_DEQUE_SIZE - 1)
+
+static void deque_init (struct pool_deque *o)
+{
+	atomic_init (&o->top, 0);
+	atomic_init (&o->bottom, 0);
+}
+
+static int deque_push (struct pool_deque *o, struct pool_task *t)
+{
+	long b = atomic_load_explicit (&o->bottom, memory_order_relaxed);
+	long t0 = atomic_load_explicit (&o->top, memory_order_acquire);
+
+	if (b - t0 > MASK)
+		return 0;
+
+	atomic_store_explicit (&o->slot[b & MASK], (uintptr_t) t,
+			       memory_order_relaxed);
+	atomic_thread_fence (memory_order_release);
+	atomic_store_explicit (&o->bottom, b + 1, memory_order_relaxed);
+	return 1;
+}
+
+static struct pool_task *deque_take (struct pool_deque *o)
+{
+	long b = atomic_load_explicit (&o->bottom, memory_order_relaxed) - 1;
+	long t0;
+	struct pool_task *t = NULL;
+
+	atomic_store_explicit (&o->bottom, b, memory_order_relaxed);
+	atomic_thread_fence (memory_order_seq_cst);
+	t0 = atomic_load_explicit (&o->top, memory_order_relaxed);
+
+	if (t0 <= b) {
+		t = (void *) atomic_load_explicit (&o->slot[b & MASK],
+						   memory_order_relaxed);
+
+		if (t0 == b) {		/* last one: race with thieves */
+			if (!atomic_compare_exchange_strong_explicit (
+				&o->top, &t0, t0 + 1,
+				memory_order_seq_cst, memory_order_relaxed))
+				t = NULL;
+
+			atomic_store_explicit (&o->bottom, b + 1,
+					       memory_order_relaxed);
+		}
+	}
+	else
+		atomic_store_explicit (&o->bottom, b + 1,
+				       memory_order_relaxed);
+
+	return t;
+}
+
+static struct pool_task *deque_steal (struct pool_deque *o)
+{
+	long t0 = atomic_load_explicit (&o->top, memory_order_acquire), b;
+	struct pool_task *t;
+
+	atomic_thread_fence (memory_order_seq_cst);
+	b = atomic_load_explicit (&o->bottom, memory_order_acquire);
+
+	if (t0 >= b)
+		return NULL;
+
+	t = (void *) atomic_load_explicit (&o->slot[t0 & MASK],
+					   memory_order_relaxed);
+
+	if (!atomic_compare_exchange_strong_explicit (&o->top, &t0, t0 + 1,
+						      memory_order_seq_cst,
+						      memory_order_relaxed))
+		return NULL;
+
+	return t;
+}
+
+static struct pool_task *queue_pop (struct pool *o)
+{
+	struct pool_task *t;
+
+	if (atomic_load (&o->queued) == 0)
+		return NULL;
+
+	mtx_lock (&o->lock);
+
+	if ((t = o->head) != NULL) {
+		if ((o->head = t->next) == NULL)
+			o->tail = &o->head;
+
+		atomic_fetch_sub (&o->queued, 1);
+	}
+
+	mtx_unlock (&o->lock);
+	return t;
+}
+
+/* own deque first, then shared queue, then steal from other workers */
+static struct pool_task *find_task (struct pool *o, struct pool_worker *w)
+{
+	struct pool_task *t;
+	int start = w != NULL ? w->id + 1 : 0, i;
+
+	if (w != NULL && (t = deque_take (&w->deque)) != NULL)
+		return t;
+
+	if ((t = queue_pop (o)) != NULL)
+		return t;
+
+	for (i = 0; i < o->count; ++i)
+		if ((t = deque_steal (&o->worker[(start + i) % o->count].deque))
+		    != NULL)
+			return t;
+
+	return NULL;
+}
+
+static void run_task (struct pool *o, struct pool_task *t)
+{
+	struct pool_group *g = t->group;
+
+	t->fn (t);
+
+	if (g != NULL && atomic_fetch_sub (&g->pending, 1) == 1)
+		eventcount_notify (&o->done);
+}
+
+static int worker_proc (void *cookie)
+{
+	struct pool_worker *w = cookie;
+	struct pool *o = w->pool;
+	struct pool_task *t;
+	unsigned key;
+
+	tss_set (o->self, w);
+
+	for (;;) {
+		if ((t = find_task (o, w)) != NULL) {
+			run_task (o, t);
+			continue;
+		}
+
+		key = eventcount_prepare (&o->work);
+
+		if ((t = find_task (o, w)) != NULL) {
+			eventcount_cancel (&o->work);
+			run_task (o, t);
+			continue;
+		}
+
+		if (atomic_load (&o->stop)) {
+			eventcount_cancel (&o->work);
+			break;
+		}
+
+		eventcount_wait (&o->work, key);
+	}
+
+	return 0;
+}
+
+int pool_init (struct pool *o, int count)
+{
+	struct thrd_attr a = { .name = "pool-worker" };
+	int i;
+
+	if (count <= 0 && (count = sysconf (_SC_NPROCESSORS_ONLN)) <= 0)
+		count = 1;
+
+	if ((o->worker = malloc (count * sizeof (o->worker[0]))) == NULL)
+		return 0;
+
+	if (tss_create (&o->self, NULL) != thrd_success)
+		goto no_tss;
+
+	if (mtx_init (&o->lock, mtx_plain) != thrd_success)
+		goto no_lock;
+
+	if (!eventcount_init (&o->work))
+		goto no_work;
+
+	if (!eventcount_init (&o->done))
+		goto no_done;
+
+	o->count = 0;
+	o->head  = NULL;
+	o->tail  = &o->head;
+	atomic_init (&o->stop, 0);
+	atomic_init (&o->queued, 0);
+
+	for (i = 0; i < count; ++i) {
+		o->worker[i].pool = o;
+		o->worker[i].id   = i;
+		deque_init (&o->worker[i].deque);
+	}
+
+	for (i = 0; i < count; ++i, ++o->count)
+		if (thrd_create_ex (&o->worker[i].thread, &a, worker_proc,
+				    o->worker + i) != thrd_success)
+			break;
+
+	if (o->count > 0)
+		return 1;
+
+	eventcount_fini (&o->done);
+no_done:
+	eventcount_fini (&o->work);
+no_work:
+	mtx_destroy (&o->lock);
+no_lock:
+	tss_delete (o->self);
+no_tss:
+	free (o->worker);
+	return 0;
+}
+
+void pool_fini (struct pool *o)
+{
+	int i;
+
+	atomic_store (&o->stop, 1);
+	eventcount_notify (&o->work);
+
+	for (i = 0; i < o->count; ++i)
+		thrd_join (o->worker[i].thread, NULL);
+
+	eventcount_fini (&o->done);
+	eventcount_fini (&o->work);
+	mtx_destroy (&o->lock);
+	tss_delete (o->self);
+	free (o->worker);
+}
+
+void pool_submit (struct pool *o, struct pool_task *t, struct pool_group *g)
+{
+	struct pool_worker *w = tss_get (o->self);
+
+	t->group = g;
+	t->next  = NULL;
+
+	if (g != NULL)
+		atomic_fetch_add (&g->pending, 1);
+
+	if (w == NULL || !deque_push (&w->deque, t)) {
+		mtx_lock (&o->lock);
+		*o->tail = t;
+		o->tail = &t->next;
+		atomic_fetch_add (&o->queued, 1);
+		mtx_unlock (&o->lock);
+	}
+
+	eventcount_notify (&o->work);
+}
+
+void pool_wait (struct pool *o, struct pool_group *g)
+{
+	struct pool_worker *w = tss_get (o->self);
+	struct pool_task *t;
+	unsigned key;
+
+	while (atomic_load (&g->pending) > 0) {
+		if (w != NULL && (t = find_task (o, w)) != NULL) {
+			run_task (o, t);
+			continue;
+		}
+
+		key = eventcount_prepare (&o->done);
+
+		if (atomic_load (&g->pending) == 0) {
+			eventcount_cancel (&o->done);
+			break;
+		}
+
+		eventcount_wait (&o->done, key);
+	}
+}
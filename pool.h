@@ -0,0 +1,88 @@
+/*
+ * Work-stealing Thread Pool
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef POOL_H
+#define POOL_H  1
+
+#include <stdint.h>
+
+#include "c11-atomics.h"
+#include "c11-threads.h"
+#include "lockfree.h"
+
+#define POOL_DEQUE_SIZE  1024	/* tasks per worker before overflow */
+
+/*
+ * Task is embedded into caller structure and must stay alive until it
+ * is run, no allocation is made per task. Task function may free it.
+ */
+struct pool_task {
+	void (*fn) (struct pool_task *o);
+	struct pool_group *group;
+	struct pool_task *next;
+};
+
+/* wait group counts submitted tasks that are not completed yet */
+struct pool_group {
+	atomic_int pending;
+};
+
+static inline void pool_group_init (struct pool_group *o)
+{
+	atomic_init (&o->pending, 0);
+}
+
+/*
+ * Chase-Lev deque: owner pushes and takes at bottom, thieves steal
+ * from top
+ */
+struct pool_deque {
+	atomic_long top;
+	char pad_top[LF_CACHE_LINE - sizeof (atomic_long)];
+	atomic_long bottom;
+	char pad_bottom[LF_CACHE_LINE - sizeof (atomic_long)];
+	atomic_uintptr_t slot[POOL_DEQUE_SIZE];
+};
+
+struct pool_worker {
+	struct pool *pool;
+	int id;
+	thrd_t thread;
+	struct pool_deque deque;
+};
+
+struct pool {
+	int count;
+	atomic_int stop;
+	struct pool_worker *worker;
+	tss_t self;
+
+	mtx_t lock;			/* guards shared overflow queue */
+	struct pool_task *head, **tail;
+	atomic_int queued;
+
+	struct eventcount work;		/* idle workers park here */
+	struct eventcount done;		/* group waiters park here */
+};
+
+/* start count workers, one per online CPU if count is zero */
+int  pool_init (struct pool *o, int count);
+
+/* run all submitted tasks to completion and stop workers */
+void pool_fini (struct pool *o);
+
+/*
+ * Queue task, from worker thread it goes to the deque of that worker.
+ * Group may be NULL.
+ */
+void pool_submit (struct pool *o, struct pool_task *t, struct pool_group *g);
+
+/* wait until all tasks of group are completed, workers run tasks here */
+void pool_wait (struct pool *o, struct pool_group *g);
+
+#endif  /* POOL_H */
@@ -0,0 +1,107 @@
+/*
+ * Program Start Latency Benchmark
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sys/wait.h>
+
+#include "pty.h"
+
+#define RUNS      200		/* per case */
+#define MiB       (1024 * 1024)
+
+static long long clock_ns (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * Time pty setup plus start of program, and that plus its exit. Parent
+ * memory is touched, thus fork has to copy page tables of it.
+ */
+static int run (int (*start) (struct pty *o, char *argv[], pid_t *child),
+		double *spawn_us, double *exit_us)
+{
+	static char *argv[] = { "true", NULL };
+	long long start_ns, spawn = 0, done = 0;
+	struct pty pty;
+	pid_t child;
+	int i, status;
+
+	for (i = 0; i < RUNS; ++i) {
+		start_ns = clock_ns ();
+
+		if (!pty_open (&pty))
+			return 0;
+
+		if (!start (&pty, argv, &child)) {
+			pty_close (&pty);
+			return 0;
+		}
+
+		spawn += clock_ns () - start_ns;
+
+		if (waitpid (child, &status, 0) != child ||
+		    !WIFEXITED (status) || WEXITSTATUS (status) != 0) {
+			pty_close (&pty);
+			return 0;
+		}
+
+		done += clock_ns () - start_ns;
+		pty_close (&pty);
+	}
+
+	*spawn_us = spawn / 1e3 / RUNS;
+	*exit_us  = done  / 1e3 / RUNS;
+	return 1;
+}
+
+int main (int argc, char *argv[])
+{
+	static const size_t sizes[] = { 0, 64, 256, 1024 };
+	size_t i, max = 1024;
+	double fs, fe, ps, pe;
+	char *p;
+
+	if (argc > 2 || (argc == 2 && (max = atol (argv[1])) == 0)) {
+		fputs ("usage:\n\tpty-test [max-rss-mib]\n", stderr);
+		return 1;
+	}
+
+	printf ("rss_mib,fork_spawn_us,fork_exit_us,"
+		"posix_spawn_us,posix_exit_us\n");
+
+	for (i = 0; i < sizeof (sizes) / sizeof (sizes[0]); ++i) {
+		if (sizes[i] > max)
+			break;
+
+		if ((p = malloc (sizes[i] * MiB + 1)) == NULL) {
+			perror ("pty-test");
+			return 1;
+		}
+
+		memset (p, 1, sizes[i] * MiB + 1);
+
+		if (!run (pty_fork, &fs, &fe) || !run (pty_spawn, &ps, &pe)) {
+			perror ("pty-test: cannot run true");
+			return 1;
+		}
+
+		printf ("%zu,%.0f,%.0f,%.0f,%.0f\n", sizes[i], fs, fe, ps, pe);
+		fflush (stdout);
+		free (p);
+	}
+
+	return 0;
+}
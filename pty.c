@@ -0,0 +1,134 @@
+/*
+ * Pseudo Terminal
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sys/ioctl.h>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+
+#include "pty.h"
+
+int pty_open (struct pty *o)
+{
+	int e;
+
+	if ((o->master = posix_openpt (O_RDWR | O_NOCTTY | O_CLOEXEC)) < 0)
+		return 0;
+
+	if (grantpt (o->master) != 0 || unlockpt (o->master) != 0)
+		goto no_slave;
+
+	if ((e = ptsname_r (o->master, o->name, sizeof (o->name))) != 0)
+		goto no_name;
+
+	return 1;
+no_slave:
+	e = errno;
+no_name:
+	close (o->master);
+	errno = e;
+	return 0;
+}
+
+void pty_close (struct pty *o)
+{
+	close (o->master);
+}
+
+/*
+ * setsid is done by POSIX_SPAWN_SETSID and opening slave in new session
+ * makes it the controlling terminal
+ */
+int pty_spawn (struct pty *o, char *argv[], pid_t *child)
+{
+#ifdef POSIX_SPAWN_SETSID
+	posix_spawn_file_actions_t fa;
+	posix_spawnattr_t sa;
+	sigset_t none;
+	int ret;
+
+	sigemptyset (&none);
+
+	if ((ret = posix_spawn_file_actions_init (&fa)) != 0)
+		goto no_actions;
+
+	if ((ret = posix_spawnattr_init (&sa)) != 0)
+		goto no_attr;
+
+	if ((ret = posix_spawnattr_setflags (&sa, POSIX_SPAWN_SETSID |
+					     POSIX_SPAWN_SETSIGMASK)) != 0 ||
+	    (ret = posix_spawnattr_setsigmask (&sa, &none)) != 0 ||
+	    (ret = posix_spawn_file_actions_addclose (&fa, o->master)) != 0 ||
+	    (ret = posix_spawn_file_actions_addopen (&fa, 0, o->name,
+						      O_RDWR, 0)) != 0 ||
+	    (ret = posix_spawn_file_actions_adddup2 (&fa, 0, 1)) != 0 ||
+	    (ret = posix_spawn_file_actions_adddup2 (&fa, 0, 2)) != 0)
+		goto no_spawn;
+
+	ret = posix_spawnp (child, argv[0], &fa, &sa, argv, environ);
+no_spawn:
+	posix_spawnattr_destroy (&sa);
+no_attr:
+	posix_spawn_file_actions_destroy (&fa);
+no_actions:
+	errno = ret;
+	return ret == 0;
+#else
+	errno = ENOSYS;
+	return 0;
+#endif
+}
+
+int pty_fork (struct pty *o, char *argv[], pid_t *child)
+{
+	int slave, e;
+	sigset_t none;
+
+	if ((slave = open (o->name, O_RDWR)) < 0)
+		return 0;
+
+	if ((*child = fork ()) < 0)
+		goto no_fork;
+
+	if (*child > 0) {
+		close (slave);
+		return 1;
+	}
+
+	close (o->master);
+
+	dup2 (slave, 0);
+	dup2 (slave, 1);
+	dup2 (slave, 2);
+
+	if (slave > 2)
+		close (slave);
+
+	setsid ();
+	ioctl (0, TIOCSCTTY, 1);
+
+	sigemptyset (&none);
+	sigprocmask (SIG_SETMASK, &none, NULL);
+
+	execvp (argv[0], argv);
+	perror ("cannot run program");
+	exit (1);
+no_fork:
+	e = errno;
+	close (slave);
+	errno = e;
+	return 0;
+}
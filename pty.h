@@ -0,0 +1,39 @@
+/*
+ * Pseudo Terminal
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef PTY_H
+#define PTY_H  1
+
+#include <sys/types.h>
+
+#define PTY_NAME  32		/* slave device name size */
+
+/* master side, close-on-exec, with unlocked slave ready to be opened */
+struct pty {
+	int master;
+	char name[PTY_NAME];
+};
+
+/* returns zero on failure */
+int  pty_open  (struct pty *o);
+void pty_close (struct pty *o);
+
+/*
+ * Start program with slave side of pty as its controlling terminal and
+ * all signals unblocked, master stays open. Return zero on failure.
+ *
+ * pty_spawn uses posix_spawn which does not copy page tables of parent
+ * as fork does, what matters when we are embedded in a large process.
+ * It fails with ENOSYS or EINVAL if C library cannot start new session
+ * this way, pty_fork should be used then: exec errors are reported by
+ * the child with exit status 1 there.
+ */
+int pty_spawn (struct pty *o, char *argv[], pid_t *child);
+int pty_fork  (struct pty *o, char *argv[], pid_t *child);
+
+#endif  /* PTY_H */
@@ -0,0 +1,185 @@
+/*
+ * Session Recording Seek and Size Benchmark
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <sys/stat.h>
+
+#include "record.h"
+
+#define ROWS    24
+#define COLS    80
+#define CHUNK   4096		/* relay read size */
+#define GAP     100000		/* between chunks, ns: program output rate */
+#define TOTAL   (16 * 1024 * 1024)
+#define SEEKS   1000
+#define PATH    "record-test.rec"
+
+static long long clock_ns (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int cmp_ll (const void *a, const void *b)
+{
+	const long long *x = a, *y = b;
+
+	return *x < *y ? -1 : *x > *y;
+}
+
+/* build log scrolling by, colored word now and then */
+static int make_log (struct buffer *b, size_t size)
+{
+	unsigned i;
+	int ok = 1;
+
+	for (i = 0; ok && b->len < size; ++i)
+		ok = buffer_adds (b, i % 16 == 0 ? "\033[32m  CC\033[0m      " :
+						 "  CC      ") &&
+		     buffer_adds (b, "drivers/net/ethernet/vendor/module-") &&
+		     buffer_addu (b, i) && buffer_adds (b, ".o\r\n");
+
+	return ok;
+}
+
+/* full screen program: redraws all rows in place, as top does */
+static int make_tui (struct buffer *b, size_t size)
+{
+	unsigned i, row;
+	int ok = 1;
+
+	for (i = 0; ok && b->len < size; ++i)
+		for (row = 1; ok && row <= ROWS; ++row)
+			ok = buffer_adds (b, "\033[") && buffer_addu (b, row) &&
+			     buffer_adds (b, ";1H\033[7m ") &&
+			     buffer_addu (b, 1000 + (i * 7 + row) % 9000) &&
+			     buffer_adds (b, " root  20  0  \033[0m  S  ") &&
+			     buffer_addu (b, (i + row) % 100) &&
+			     buffer_adds (b, ".0  0:00.12 process\033[K");
+
+	return ok;
+}
+
+struct input {
+	const char *name;
+	int (*make) (struct buffer *b, size_t size);
+};
+
+static const struct input cases[] = {
+	{ "log", make_log },
+	{ "tui", make_tui },
+	{ NULL }
+};
+
+struct result {
+	double mb_s, ratio, write_p99, seek_p50, seek_p99;
+	size_t keys;
+};
+
+/*
+ * Record input as output relay does, in chunks spread over time, then
+ * seek to random times. Record throughput counts time spent in record
+ * calls only.
+ */
+static int run (const struct buffer *in, struct result *r)
+{
+	static long long time[TOTAL / CHUNK + 2];
+	struct recorder rec;
+	struct player p;
+	struct buffer out;
+	struct timespec gap = { 0, GAP };
+	struct stat st;
+	long long start, spent = 0, end;
+	size_t pos, n, i, count = 0;
+	FILE *f;
+
+	if (!record_init (&rec, PATH, ROWS, COLS))
+		return 0;
+
+	for (pos = 0; pos < in->len; pos += n, ++count) {
+		n = in->len - pos < CHUNK ? in->len - pos : CHUNK;
+		start = clock_ns ();
+		record_write (&rec, in->data + pos, n);
+		spent += time[count] = clock_ns () - start;
+		nanosleep (&gap, NULL);
+	}
+
+	start = clock_ns ();
+
+	if (!record_fini (&rec) || stat (PATH, &st) != 0)
+		return 0;
+
+	spent += clock_ns () - start;
+	qsort (time, count, sizeof (time[0]), cmp_ll);
+
+	r->mb_s      = in->len * 1e3 / spent;
+	r->ratio     = (double) st.st_size / in->len;
+	r->write_p99 = time[count * 99 / 100] / 1e3;
+
+	if ((f = fopen (PATH, "rb")) == NULL || !player_open (&p, f))
+		return 0;
+
+	buffer_init (&out);
+	end = p.index[p.count - 1].time;
+	srand (1);
+
+	for (i = 0; i < SEEKS; ++i) {
+		buffer_reset (&out);
+		start = clock_ns ();
+
+		if (!player_seek (&p, rand () % (end + 1), &out))
+			break;
+
+		time[i] = clock_ns () - start;
+	}
+
+	r->keys = p.count;
+	buffer_fini (&out);
+	player_close (&p);
+	remove (PATH);
+
+	if (i < SEEKS)
+		return 0;
+
+	qsort (time, SEEKS, sizeof (time[0]), cmp_ll);
+	r->seek_p50 = time[SEEKS / 2] / 1e3;
+	r->seek_p99 = time[SEEKS * 99 / 100] / 1e3;
+	return 1;
+}
+
+int main (void)
+{
+	const struct input *c;
+	struct buffer in;
+	struct result r;
+
+	printf ("input,mib,record_mb_s,write_p99_us,file_ratio,keyframes,"
+		"seek_p50_us,seek_p99_us\n");
+
+	for (c = cases; c->name != NULL; ++c) {
+		buffer_init (&in);
+
+		if (!c->make (&in, TOTAL) || !run (&in, &r)) {
+			perror ("record-test");
+			return 1;
+		}
+
+		printf ("%s,%.1f,%.1f,%.0f,%.3f,%zu,%.0f,%.0f\n", c->name,
+			in.len / (1024.0 * 1024), r.mb_s, r.write_p99, r.ratio,
+			r.keys, r.seek_p50, r.seek_p99);
+		fflush (stdout);
+		buffer_fini (&in);
+	}
+
+	return 0;
+}
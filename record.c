@@ -0,0 +1,335 @@
+/*
+ * Seekable Session Recording
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "record.h"
+
+static const char rec_magic[8] = "TFREC1";
+static const char idx_magic[8] = "TFRIDX1";
+
+static int rec_put (struct recorder *o, const void *data, size_t len)
+{
+	if (o->ok && !logger_write (&o->log, data, len))
+		o->ok = 0;
+
+	o->offset += len;
+	return o->ok;
+}
+
+static int rec_frame (struct recorder *o, int type, uint64_t time,
+		      const struct buffer *b)
+{
+	struct rec_frame h = { .time = time, .len = b->len, .type = type };
+
+	return rec_put (o, &h, sizeof (h)) && rec_put (o, b->data, b->len);
+}
+
+static uint64_t rec_clock (struct recorder *o)
+{
+	struct timespec now;
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - o->start.tv_sec) * 1000000LL +
+	       (now.tv_nsec - o->start.tv_nsec) / 1000;
+}
+
+static int rec_flush (struct recorder *o)
+{
+	int ok;
+
+	if (o->data.len == 0)
+		return o->ok;
+
+	ok = rec_frame (o, REC_DATA, o->time, &o->data);
+	buffer_reset (&o->data);
+	return ok;
+}
+
+static int rec_key (struct recorder *o, uint64_t time)
+{
+	struct rec_index *p;
+	size_t size;
+
+	if (!rec_flush (o))
+		return 0;
+
+	if (o->count == o->size) {
+		size = o->size * 2 + 64;
+
+		if ((p = realloc (o->index, size * sizeof (p[0]))) == NULL)
+			return o->ok = 0;
+
+		o->index = p;
+		o->size  = size;
+	}
+
+	buffer_reset (&o->key);
+
+	if (!screen_keyframe (&o->screen, &o->key))
+		return o->ok = 0;
+
+	o->index[o->count].time   = time;
+	o->index[o->count].offset = o->offset;
+	++o->count;
+
+	o->key_time  = time;
+	o->key_bytes = 0;
+	return rec_frame (o, REC_KEY, time, &o->key);
+}
+
+static void rec_fini (struct recorder *o)
+{
+	free (o->index);
+	buffer_fini (&o->key);
+	buffer_fini (&o->data);
+	screen_fini (&o->screen);
+}
+
+int record_init (struct recorder *o, const char *path, int rows, int cols)
+{
+	struct rec_header h = { .rows = rows, .cols = cols };
+
+	memcpy (h.magic, rec_magic, sizeof (h.magic));
+
+	if (!screen_init (&o->screen, rows, cols)) {
+		errno = ENOMEM;
+		return 0;
+	}
+
+	if (!logger_init (&o->log, path, 0)) {
+		screen_fini (&o->screen);
+		return 0;
+	}
+
+	o->ok = 1;
+	o->offset = 0;
+	o->time = 0;
+	o->index = NULL;
+	o->count = o->size = 0;
+
+	buffer_init (&o->data);
+	buffer_init (&o->key);
+	clock_gettime (CLOCK_MONOTONIC, &o->start);
+
+	if (!rec_put (o, &h, sizeof (h)) || !rec_key (o, 0)) {
+		logger_fini (&o->log);
+		rec_fini (o);
+		errno = ENOMEM;
+		return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * Keyframe is taken only when chunk ends outside of escape sequence and
+ * UTF-8 character, thus delta that follows it can be decoded alone.
+ */
+int record_write (struct recorder *o, const char *data, size_t len)
+{
+	uint64_t now = rec_clock (o);
+
+	if (!o->ok || len == 0)
+		return o->ok;
+
+	screen_write (&o->screen, data, len);
+
+	if (o->data.len > 0 && now - o->time >= REC_MERGE)
+		rec_flush (o);
+
+	if (o->data.len == 0)
+		o->time = now;
+
+	if (!buffer_add (&o->data, data, len))
+		return o->ok = 0;
+
+	o->key_bytes += len;
+
+	if ((o->key_bytes >= REC_KEYBYTES || now - o->key_time >= REC_KEYTIME)
+	    && (unsigned char) data[len - 1] < 0x80 &&
+	    vt_parser_ground (&o->screen.parser))
+		return rec_key (o, now);
+
+	return o->ok;
+}
+
+int record_fini (struct recorder *o)
+{
+	struct rec_trailer t = { .count = o->count };
+	int ok;
+
+	memcpy (t.magic, idx_magic, sizeof (t.magic));
+
+	rec_flush (o);
+	t.offset = o->offset;
+
+	rec_put (o, o->index, o->count * sizeof (o->index[0]));
+	rec_put (o, &t, sizeof (t));
+
+	ok = logger_fini (&o->log) && o->ok;
+	rec_fini (o);
+	return ok;
+}
+
+/* Player */
+
+static int read_payload (FILE *f, size_t len, struct buffer *out)
+{
+	if (!buffer_grow (out, len) ||
+	    fread (out->data + out->len, 1, len, f) != len)
+		return 0;
+
+	out->len += len;
+	return 1;
+}
+
+static int read_frame (struct player *o, struct rec_frame *frame)
+{
+	return ftello (o->f) < (off_t) o->end &&
+	       fread (frame, sizeof (*frame), 1, o->f) == 1 &&
+	       (frame->type == REC_DATA || frame->type == REC_KEY);
+}
+
+static int player_add (struct player *o, size_t *size, uint64_t time,
+		       uint64_t offset)
+{
+	struct rec_index *p;
+
+	if (o->count == *size) {
+		*size = *size * 2 + 64;
+
+		if ((p = realloc (o->index, *size * sizeof (p[0]))) == NULL)
+			return 0;
+
+		o->index = p;
+	}
+
+	o->index[o->count].time   = time;
+	o->index[o->count].offset = offset;
+	++o->count;
+	return 1;
+}
+
+/* recording was cut short: find keyframes and end of complete frames */
+static int player_scan (struct player *o)
+{
+	struct rec_frame frame;
+	off_t pos = sizeof (o->head), size;
+	size_t count = 0;
+
+	if (fseeko (o->f, 0, SEEK_END) != 0 || (size = ftello (o->f)) < 0)
+		return 0;
+
+	o->end = size;
+
+	while (fseeko (o->f, pos, SEEK_SET) == 0 && read_frame (o, &frame) &&
+	       pos + sizeof (frame) + frame.len <= (uint64_t) size) {
+		if (frame.type == REC_KEY &&
+		    !player_add (o, &count, frame.time, pos))
+			return 0;
+
+		pos += sizeof (frame) + frame.len;
+	}
+
+	o->end = pos;
+	return o->count > 0;
+}
+
+static int player_load (struct player *o)
+{
+	struct rec_trailer t;
+	size_t len;
+
+	if (fseeko (o->f, -(off_t) sizeof (t), SEEK_END) != 0 ||
+	    fread (&t, sizeof (t), 1, o->f) != 1 ||
+	    memcmp (t.magic, idx_magic, sizeof (t.magic)) != 0 || t.count == 0)
+		return player_scan (o);
+
+	len = t.count * sizeof (o->index[0]);
+
+	if ((o->index = malloc (len)) == NULL ||
+	    fseeko (o->f, t.offset, SEEK_SET) != 0 ||
+	    fread (o->index, len, 1, o->f) != 1)
+		return 0;
+
+	o->count = t.count;
+	o->end = t.offset;
+	return 1;
+}
+
+int player_open (struct player *o, FILE *f)
+{
+	o->f = f;
+	o->index = NULL;
+	o->count = 0;
+
+	if (fread (&o->head, sizeof (o->head), 1, f) != 1 ||
+	    memcmp (o->head.magic, rec_magic, sizeof (o->head.magic)) != 0 ||
+	    !player_load (o) || fseeko (f, o->index[0].offset, SEEK_SET) != 0) {
+		free (o->index);
+		return 0;
+	}
+
+	return 1;
+}
+
+void player_close (struct player *o)
+{
+	fclose (o->f);
+	free (o->index);
+}
+
+int player_seek (struct player *o, uint64_t time, struct buffer *out)
+{
+	struct rec_frame frame;
+	size_t lo = 0, hi = o->count, mid, base = out->len;
+	off_t pos;
+
+	/* last keyframe not after time, first one is at zero */
+	while (hi - lo > 1) {
+		mid = lo + (hi - lo) / 2;
+
+		if (o->index[mid].time <= time)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	if (fseeko (o->f, o->index[lo].offset, SEEK_SET) != 0)
+		return 0;
+
+	for (;;) {
+		pos = ftello (o->f);
+
+		if (!read_frame (o, &frame))
+			break;
+
+		if (frame.time > time && pos != (off_t) o->index[lo].offset) {
+			fseeko (o->f, pos, SEEK_SET);
+			break;
+		}
+
+		if (frame.type == REC_KEY)
+			out->len = base;
+
+		if (!read_payload (o->f, frame.len, out))
+			return 0;
+	}
+
+	return 1;
+}
+
+int player_next (struct player *o, struct rec_frame *frame,
+		 struct buffer *out)
+{
+	return read_frame (o, frame) && read_payload (o->f, frame->len, out);
+}
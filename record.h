@@ -0,0 +1,107 @@
+/*
+ * Seekable Session Recording
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef RECORD_H
+#define RECORD_H  1
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "buffer.h"
+#include "logger.h"
+#include "screen.h"
+
+#define REC_KEYBYTES  (256 * 1024)	/* output between keyframes */
+#define REC_KEYTIME   10000000		/* or time between them, us */
+#define REC_MERGE     10000		/* output merged into one frame, us */
+
+/*
+ * File starts with header, then frames follow: keyframe with sequence
+ * that draws whole screen and program output deltas. Keyframe index and
+ * trailer pointing to it are written at the end. All numbers are in
+ * native byte order.
+ *
+ * Frames are written through a logger, thus the relay never blocks on
+ * file writes, only on a full logger queue.
+ */
+struct rec_header {
+	char magic[8];			/* "TFREC1" */
+	uint32_t rows, cols;
+};
+
+enum rec_type {
+	REC_DATA	= 1,
+	REC_KEY		= 2,
+};
+
+struct rec_frame {
+	uint64_t time;			/* us since start */
+	uint32_t len;			/* payload follows */
+	uint32_t type;
+};
+
+struct rec_index {
+	uint64_t time, offset;
+};
+
+struct rec_trailer {
+	char magic[8];			/* "TFRIDX1" */
+	uint64_t count, offset;
+};
+
+struct recorder {
+	struct logger log;
+	int ok;
+	struct timespec start;
+	uint64_t offset;		/* of next frame */
+	uint64_t time, key_time;	/* of pending delta and last keyframe */
+	size_t key_bytes;		/* output since last keyframe */
+	struct buffer data, key;	/* pending delta, keyframe scratch */
+	struct rec_index *index;
+	size_t count, size;
+	struct screen screen;
+};
+
+/* returns zero on failure with errno set */
+int record_init (struct recorder *o, const char *path, int rows, int cols);
+
+/* record next chunk of program output */
+int record_write (struct recorder *o, const char *data, size_t len);
+
+/* write index and close file, returns zero if recording failed */
+int record_fini (struct recorder *o);
+
+/*
+ * Player finds keyframe by binary search in the index and decodes
+ * deltas from there, so seek time does not depend on recording length.
+ * Recordings without index (cut short) are scanned once to build it.
+ */
+struct player {
+	FILE *f;
+	struct rec_header head;
+	struct rec_index *index;
+	size_t count;
+	uint64_t end;			/* of frames */
+};
+
+/* returns zero on failure, file is owned by player on success */
+int  player_open  (struct player *o, FILE *f);
+void player_close (struct player *o);
+
+/*
+ * Append sequence that brings terminal to its state at given time and
+ * leave player positioned at following frame
+ */
+int player_seek (struct player *o, uint64_t time, struct buffer *out);
+
+/* read next frame appending its payload, returns zero at end */
+int player_next (struct player *o, struct rec_frame *frame,
+		 struct buffer *out);
+
+#endif  /* RECORD_H */
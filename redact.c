@@ -0,0 +1,108 @@
+/*
+ * Secret Redaction Stage
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "redact.h"
+
+static int load (struct redact *o, const char *path)
+{
+	char *line = NULL;
+	size_t size = 0;
+	ssize_t len;
+	FILE *f;
+	int ok, e = 0;
+
+	if ((f = fopen (path, "r")) == NULL)
+		return 0;
+
+	for (o->line = 1; (len = getline (&line, &size, f)) >= 0; ++o->line) {
+		while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+			--len;
+
+		if (len > 0 && line[0] != '#' && !match_add (&o->m, line, len)) {
+			e = errno;
+			break;
+		}
+	}
+
+	ok = e == 0 && feof (f) && !ferror (f);
+	free (line);
+	fclose (f);
+
+	if (e != 0)
+		errno = e;
+
+	return ok;
+}
+
+int redact_init (struct redact *o, const char *path)
+{
+	match_init (&o->m);
+	o->held = 0;
+
+	if (load (o, path) && match_compile (&o->m))
+		return 1;
+
+	match_fini (&o->m);
+	return 0;
+}
+
+void redact_fini (struct redact *o)
+{
+	match_fini (&o->m);
+}
+
+struct mask {
+	const struct match *m;
+	char *data;			/* new data, held bytes before it */
+	size_t held;
+};
+
+static void mask_fn (void *ctx, size_t id, size_t end)
+{
+	struct mask *o = ctx;
+	size_t len = o->m->len[id];
+
+	if (len > o->held + end)
+		len = o->held + end;
+
+	memset (o->data + end - len, REDACT_MASK, len);
+}
+
+int redact_write (struct redact *o, const char *data, size_t len,
+		  struct buffer *out)
+{
+	struct mask m = { &o->m, NULL, o->held };
+	size_t total = o->held + len, keep;
+
+	if (!buffer_grow (out, total))
+		return 0;
+
+	m.data = out->data + out->len + o->held;
+	memcpy (m.data - o->held, o->hold, o->held);
+	memcpy (m.data, data, len);
+
+	keep = match_run (&o->m, data, len, mask_fn, &m);
+
+	o->held = keep < total ? keep : total;
+	memcpy (o->hold, m.data + len - o->held, o->held);
+	out->len += total - o->held;
+	return 1;
+}
+
+int redact_flush (struct redact *o, struct buffer *out)
+{
+	int ok = buffer_add (out, o->hold, o->held);
+
+	o->held = 0;
+	return ok;
+}
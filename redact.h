@@ -0,0 +1,45 @@
+/*
+ * Secret Redaction Stage
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef REDACT_H
+#define REDACT_H  1
+
+#include <stddef.h>
+
+#include "buffer.h"
+#include "match.h"
+
+#define REDACT_MASK  '*'
+
+/*
+ * Matches are masked byte for byte even when they cross chunks: only the
+ * longest pattern prefix still alive is held back at chunk end.
+ */
+struct redact {
+	struct match m;
+	size_t held;
+	char hold[MATCH_LEN];
+	int line;			/* of pattern error */
+};
+
+/*
+ * Load patterns from file, one per line, empty lines and lines starting
+ * with # are skipped. Returns zero on failure with errno set: EINVAL for
+ * wrong pattern at line.
+ */
+int  redact_init (struct redact *o, const char *path);
+void redact_fini (struct redact *o);
+
+/* mask next chunk and append what is not held back */
+int redact_write (struct redact *o, const char *data, size_t len,
+		  struct buffer *out);
+
+/* append held back data as is, e.g. when output goes idle */
+int redact_flush (struct redact *o, struct buffer *out);
+
+#endif  /* REDACT_H */
@@ -0,0 +1,199 @@
+/*
+ * Single Producer Single Consumer Byte Ring Benchmark
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include <sys/prctl.h>
+
+#include "ring.h"
+
+#define CHUNK     512		/* relay read size */
+#define RINGSIZE  65536
+#define MiB       (1024 * 1024)
+
+/*
+ * Relay direction model: reader stage produces chunks taking filter ns
+ * of CPU time per chunk, writer stage blocks for call ns per write plus
+ * byte ns per byte written, as write to slow terminal or link does.
+ * Direct mode does both in one thread, piped one moves writes through
+ * the ring into a thread of its own, which writes everything queued at
+ * once.
+ */
+struct bench {
+	const char *name;
+	long filter, call, byte;	/* costs, ns */
+	int mib;
+};
+
+static const struct bench cases[] = {
+	{ "fast",      0,    0,     0,   256 },
+	{ "slow-call", 5000, 20000, 0,   8 },
+	{ "slow-rate", 5000, 5000,  100, 8 },
+	{ NULL }
+};
+
+struct writer {
+	struct ring ring;
+	const struct bench *b;
+	size_t pos;			/* bytes checked */
+	int ok;
+};
+
+static long long clock_ns (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void spin (long long ns)
+{
+	long long end;
+
+	if (ns <= 0)
+		return;
+
+	for (end = clock_ns () + ns; clock_ns () < end;) {}
+}
+
+static void block (long long ns)
+{
+	struct timespec ts = { ns / 1000000000, ns % 1000000000 };
+
+	if (ns > 0)
+		nanosleep (&ts, NULL);
+}
+
+static void produce (char *p, size_t pos, long filter)
+{
+	size_t i;
+
+	for (i = 0; i < CHUNK; ++i)
+		p[i] = (pos + i) % 251;
+
+	spin (filter);
+}
+
+/* check order of bytes and pay for write */
+static int consume (struct writer *o, const char *p, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; ++i)
+		if (p[i] != (char) ((o->pos + i) % 251))
+			return 0;
+
+	o->pos += len;
+	block (o->b->call + o->b->byte * (long long) len);
+	return 1;
+}
+
+static int run_direct (struct writer *o, size_t total)
+{
+	char buf[CHUNK];
+	size_t pos;
+
+	for (pos = 0; pos < total; pos += CHUNK) {
+		produce (buf, pos, o->b->filter);
+
+		if (!consume (o, buf, CHUNK))
+			return 0;
+	}
+
+	return 1;
+}
+
+static int writer_proc (void *data)
+{
+	struct writer *o = data;
+	const char *p;
+	size_t n;
+
+	while ((n = ring_peek (&o->ring, &p)) > 0) {
+		if (!consume (o, p, n)) {
+			o->ok = 0;
+			ring_shutdown (&o->ring);
+			break;
+		}
+
+		ring_consume (&o->ring, n);
+	}
+
+	return 0;
+}
+
+static int run_piped (struct writer *o, size_t total)
+{
+	char buf[CHUNK];
+	size_t pos;
+	thrd_t t;
+
+	if (!ring_init (&o->ring, RINGSIZE))
+		return 0;
+
+	if (thrd_create (&t, writer_proc, o) != thrd_success) {
+		ring_fini (&o->ring);
+		return 0;
+	}
+
+	for (pos = 0; pos < total; pos += CHUNK) {
+		produce (buf, pos, o->b->filter);
+
+		if (!ring_put (&o->ring, buf, CHUNK))
+			break;
+	}
+
+	ring_close (&o->ring);
+	thrd_join (t, NULL);
+	ring_fini (&o->ring);
+	return o->ok;
+}
+
+int main (void)
+{
+	static const char *mode[] = { "direct", "piped" };
+	const struct bench *b;
+	struct writer o;
+	size_t total;
+	long long start;
+	double time;
+	int i, ok;
+
+	/* default slack of 50 us would dominate write costs */
+	prctl (PR_SET_TIMERSLACK, 1);
+
+	printf ("case,mode,mib,time_s,mb_s\n");
+
+	for (b = cases; b->name != NULL; ++b)
+		for (i = 0; i < 2; ++i) {
+			o.b   = b;
+			o.pos = 0;
+			o.ok  = 1;
+			total = (size_t) b->mib * MiB;
+
+			start = clock_ns ();
+			ok = i == 0 ? run_direct (&o, total) :
+				      run_piped (&o, total);
+			time = (clock_ns () - start) / 1e9;
+
+			if (!ok || o.pos != total) {
+				fprintf (stderr, "ring-test: %s %s: data lost or "
+					 "reordered at %zu\n", b->name, mode[i],
+					 o.pos);
+				return 1;
+			}
+
+			printf ("%s,%s,%d,%.3f,%.1f\n", b->name, mode[i], b->mib,
+				time, total / 1e6 / time);
+			fflush (stdout);
+		}
+
+	return 0;
+}
@@ -0,0 +1,210 @@
+/*
+ * Single Producer Single Consumer Byte Ring
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ring.h"
+
+enum ring_wait {
+	RING_PRODUCER	= 1,
+	RING_CONSUMER	= 2,
+};
+
+#define RING_SPIN  64		/* checks before going to sleep */
+
+int ring_init (struct ring *o, size_t size)
+{
+	if ((o->data = malloc (size)) == NULL)
+		return 0;
+
+	if (mtx_init (&o->lock, mtx_plain) != thrd_success)
+		goto no_lock;
+
+	if (cnd_init (&o->cond) != thrd_success)
+		goto no_cond;
+
+	o->size = size;
+	atomic_init (&o->head, 0);
+	atomic_init (&o->tail, 0);
+	atomic_init (&o->waiting, 0);
+	atomic_init (&o->closed, 0);
+	atomic_init (&o->shut, 0);
+	return 1;
+no_cond:
+	mtx_destroy (&o->lock);
+no_lock:
+	free (o->data);
+	return 0;
+}
+
+void ring_fini (struct ring *o)
+{
+	cnd_destroy (&o->cond);
+	mtx_destroy (&o->lock);
+	free (o->data);
+}
+
+static void ring_wake (struct ring *o, int side)
+{
+	if ((atomic_load (&o->waiting) & side) == 0)
+		return;
+
+	mtx_lock (&o->lock);
+	cnd_broadcast (&o->cond);
+	mtx_unlock (&o->lock);
+}
+
+/*
+ * Wait until ready returns non-zero or CLOCK_MONOTONIC deadline if any,
+ * returns zero on timeout. Waiting flag is set before the last check
+ * under the lock, and the other side tests it after publishing its
+ * counter, so a wakeup cannot be lost.
+ */
+static int ring_wait (struct ring *o, int side,
+		      int (*ready) (struct ring *o),
+		      const struct timespec *deadline)
+{
+	int i, ok;
+
+	for (i = 0; i < RING_SPIN; ++i)
+		if (ready (o))
+			return 1;
+
+	mtx_lock (&o->lock);
+	atomic_fetch_or (&o->waiting, side);
+
+	while (!(ok = ready (o)))
+		if (deadline == NULL)
+			cnd_wait (&o->cond, &o->lock);
+		else if (cnd_timedwait_ex (&o->cond, &o->lock, deadline,
+					   CLOCK_MONOTONIC) == thrd_timedout) {
+			ok = ready (o);
+			break;
+		}
+
+	atomic_fetch_and (&o->waiting, ~side);
+	mtx_unlock (&o->lock);
+	return ok;
+}
+
+static int can_put (struct ring *o)
+{
+	return atomic_load (&o->head) - atomic_load (&o->tail) < o->size ||
+	       atomic_load (&o->shut);
+}
+
+int ring_put (struct ring *o, const void *data, size_t len)
+{
+	const char *p = data;
+	size_t head, avail, off, n;
+
+	while (len > 0) {
+		ring_wait (o, RING_PRODUCER, can_put, NULL);
+
+		if (atomic_load (&o->shut))
+			return 0;
+
+		head  = atomic_load_explicit (&o->head, memory_order_relaxed);
+		avail = o->size - (head - atomic_load_explicit (&o->tail,
+						memory_order_acquire));
+		off   = head & (o->size - 1);
+		n     = o->size - off;		/* up to the end of storage */
+
+		n = n < avail ? n : avail;
+		n = n < len   ? n : len;
+
+		memcpy (o->data + off, p, n);
+		atomic_store (&o->head, head + n);
+		ring_wake (o, RING_CONSUMER);
+
+		p += n, len -= n;
+	}
+
+	return 1;
+}
+
+int ring_try_put (struct ring *o, const void *data, size_t len)
+{
+	/* only producer adds data, thus free space cannot shrink */
+	if (o->size - ring_level (o) < len || atomic_load (&o->shut))
+		return 0;
+
+	return ring_put (o, data, len);
+}
+
+void ring_close (struct ring *o)
+{
+	atomic_store (&o->closed, 1);
+
+	mtx_lock (&o->lock);
+	cnd_broadcast (&o->cond);
+	mtx_unlock (&o->lock);
+}
+
+static int can_peek (struct ring *o)
+{
+	return atomic_load (&o->head) != atomic_load (&o->tail) ||
+	       atomic_load (&o->closed);
+}
+
+size_t ring_peek (struct ring *o, const char **data)
+{
+	size_t head, tail, off, n;
+
+	ring_wait (o, RING_CONSUMER, can_peek, NULL);
+
+	head = atomic_load_explicit (&o->head, memory_order_acquire);
+	tail = atomic_load_explicit (&o->tail, memory_order_relaxed);
+	off  = tail & (o->size - 1);
+	n    = o->size - off;
+
+	*data = o->data + off;
+	return head - tail < n ? head - tail : n;
+}
+
+int ring_poll (struct ring *o, int timeout)
+{
+	struct timespec deadline;
+
+	if (timeout <= 0)
+		return can_peek (o);
+
+	clock_gettime (CLOCK_MONOTONIC, &deadline);
+
+	deadline.tv_sec  += timeout / 1000;
+	deadline.tv_nsec += timeout % 1000 * 1000000L;
+
+	if (deadline.tv_nsec >= 1000000000) {
+		deadline.tv_nsec -= 1000000000;
+		++deadline.tv_sec;
+	}
+
+	return ring_wait (o, RING_CONSUMER, can_peek, &deadline);
+}
+
+size_t ring_level (struct ring *o)
+{
+	return atomic_load (&o->head) - atomic_load (&o->tail);
+}
+
+void ring_consume (struct ring *o, size_t len)
+{
+	atomic_fetch_add (&o->tail, len);
+	ring_wake (o, RING_PRODUCER);
+}
+
+void ring_shutdown (struct ring *o)
+{
+	atomic_store (&o->shut, 1);
+
+	mtx_lock (&o->lock);
+	cnd_broadcast (&o->cond);
+	mtx_unlock (&o->lock);
+}
@@ -0,0 +1,62 @@
+/*
+ * Single Producer Single Consumer Byte Ring
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef RING_H
+#define RING_H  1
+
+#include <stddef.h>
+
+#include "c11-atomics.h"
+#include "c11-threads.h"
+
+#define RING_ALIGN  64		/* cache line size */
+
+/*
+ * Head is advanced by producer only, tail by consumer only, both are
+ * free-running counters kept on separate cache lines. Transfers are
+ * lock-free, the lock is taken only to sleep when the ring is full or
+ * empty and to wake up the sleeping side.
+ */
+struct ring {
+	_Alignas (RING_ALIGN) atomic_size_t head;
+	_Alignas (RING_ALIGN) atomic_size_t tail;
+	_Alignas (RING_ALIGN) atomic_int waiting;	/* RING_* wait flags */
+	atomic_int closed, shut;
+	char *data;
+	size_t size;
+	mtx_t lock;
+	cnd_t cond;
+};
+
+/* size must be a power of two, returns zero on failure */
+int  ring_init (struct ring *o, size_t size);
+void ring_fini (struct ring *o);
+
+/*
+ * Producer side: copy all data into ring waiting for free space, returns
+ * zero if consumer has shut the ring down. Try put never waits and
+ * copies nothing if all data does not fit. Close signals end of stream.
+ */
+int  ring_put     (struct ring *o, const void *data, size_t len);
+int  ring_try_put (struct ring *o, const void *data, size_t len);
+void ring_close   (struct ring *o);
+
+/*
+ * Consumer side: wait for data and return length of contiguous readable
+ * region, zero at end of stream. Poll waits for the same up to timeout
+ * ms and returns zero if peek would still block. Level returns amount
+ * of queued data without waiting. Consume releases space to producer,
+ * shutdown makes producer fail.
+ */
+size_t ring_peek     (struct ring *o, const char **data);
+int    ring_poll     (struct ring *o, int timeout);
+size_t ring_level    (struct ring *o);
+void   ring_consume  (struct ring *o, size_t len);
+void   ring_shutdown (struct ring *o);
+
+#endif  /* RING_H */
@@ -0,0 +1,248 @@
+/*
+ * Screen Diff Bandwidth Benchmark
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "screen.h"
+
+#define ROWS      24
+#define COLS      80
+#define DURATION  60000		/* of every workload, ms */
+
+/*
+ * Replays timed program output through screen models the way diff
+ * format does, on virtual clock: frame is sent when screen is dirty
+ * and frame period since previous one passed.
+ */
+struct sim {
+	struct screen s, peer;
+	struct buffer b;
+	int period;			/* ms, zero passes output as is */
+	long long next, dirty;		/* next frame time, dirty since */
+	unsigned long in, out, frames;
+};
+
+static int sim_init (struct sim *o, int rate)
+{
+	if (!screen_init (&o->s, ROWS, COLS))
+		return 0;
+
+	if (!screen_init (&o->peer, ROWS, COLS)) {
+		screen_fini (&o->s);
+		return 0;
+	}
+
+	buffer_init (&o->b);
+	o->period = rate > 0 ? 1000 / rate : 0;
+	o->next = o->dirty = 0;
+	o->in = o->out = o->frames = 0;
+	return 1;
+}
+
+static void sim_fini (struct sim *o)
+{
+	buffer_fini (&o->b);
+	screen_fini (&o->peer);
+	screen_fini (&o->s);
+}
+
+static void sim_frame (struct sim *o, long long now)
+{
+	buffer_reset (&o->b);
+
+	if (screen_update (&o->s, &o->peer, &o->b)) {
+		o->out += o->b.len;
+		++o->frames;
+	}
+
+	o->next = now + o->period;
+}
+
+/* send frames due before time t */
+static void sim_clock (struct sim *o, long long t)
+{
+	long long due;
+
+	if (o->period == 0 || !o->s.dirty)
+		return;
+
+	if ((due = o->dirty > o->next ? o->dirty : o->next) <= t)
+		sim_frame (o, due);
+}
+
+static void sim_feed (struct sim *o, long long t, const char *data, size_t len)
+{
+	o->in += len;
+
+	if (o->period == 0) {
+		o->out += len;
+		++o->frames;
+		return;
+	}
+
+	sim_clock (o, t);
+
+	if (!o->s.dirty)
+		o->dirty = t;
+
+	screen_write (&o->s, data, len);
+}
+
+static void sim_printf (struct sim *o, long long t, const char *fmt, ...)
+{
+	char buf[4096];
+	va_list ap;
+	int len;
+
+	va_start (ap, fmt);
+	len = vsnprintf (buf, sizeof (buf), fmt, ap);
+	va_end (ap);
+
+	if (len > 0 && len < (int) sizeof (buf))
+		sim_feed (o, t, buf, len);
+}
+
+static uint64_t rnd_state = 88172645463325252ull;
+
+static unsigned rnd (unsigned n)
+{
+	uint64_t x = rnd_state;
+
+	x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+	rnd_state = x;
+	return (x >> 32) % n;
+}
+
+/* Workloads */
+
+/* process monitor: full redraw every second, few fields change */
+static void run_top (struct sim *o)
+{
+	long long t;
+	int row;
+
+	for (t = 0; t < DURATION; t += 1000) {
+		sim_printf (o, t, "\033[H\033[1mtop - %02lld:%02lld up 3 days, "
+			    "load average: 0.%02u, 0.%02u\033[m\033[K\r\n",
+			    t / 60000, t / 1000 % 60, rnd (100), rnd (100));
+
+		for (row = 1; row < ROWS - 1; ++row)
+			sim_printf (o, t, "%5d user  20   0 %7u %6u S %4.1f "
+				    "%4.1f  0:%02u.%02u proc-%02d\033[K\r\n",
+				    1000 + row, 100000 + row * 37, 5000 + row,
+				    rnd (200) / 10.0, row / 10.0, row, rnd (100),
+				    row);
+
+		sim_printf (o, t, "\033[J");
+	}
+}
+
+/* tail -f: a burst of log lines every 100 ms */
+static void run_log (struct sim *o)
+{
+	long long t;
+	int i;
+
+	for (t = 0; t < DURATION; t += 100)
+		for (i = rnd (20); i > 0; --i)
+			sim_printf (o, t, "%lld.%03lld INFO worker-%u: request "
+				    "%u done in %u ms\r\n", t / 1000, t % 1000,
+				    rnd (8), rnd (100000), rnd (500));
+}
+
+/* progress bar redrawn in place every ms */
+static void run_progress (struct sim *o)
+{
+	char bar[51];
+	long long t;
+	int done;
+
+	for (t = 0; t < DURATION; ++t) {
+		done = t * 50 / DURATION;
+		memset (bar, '#', done);
+		memset (bar + done, '.', 50 - done);
+		bar[50] = '\0';
+
+		sim_printf (o, t, "\r[%s] %3lld%% %8lld bytes", bar,
+			    t * 100 / DURATION, t * 1377);
+	}
+}
+
+/* editor: typing with status line and cursor position updates */
+static void run_editor (struct sim *o)
+{
+	long long t;
+	int row = 1, col = 1;
+
+	sim_printf (o, 0, "\033[?1049h\033[H\033[2J");
+
+	for (row = 1; row < ROWS; ++row)
+		sim_printf (o, 0, "\033[%d;1H~", row);
+
+	for (t = 0, row = 1; t < DURATION; t += 80 + rnd (120)) {
+		sim_printf (o, t, "\033[%d;%dH%c", row, col, 'a' + rnd (26));
+
+		if (++col > 72 || rnd (12) == 0) {
+			col = 1;
+			row = row % (ROWS - 2) + 1;
+		}
+
+		sim_printf (o, t, "\033[%d;1H\033[7m -- INSERT -- %*d,%-3d "
+			    "\033[m\033[K\033[%d;%dH", ROWS, 56, row, col, row,
+			    col);
+	}
+
+	sim_printf (o, t, "\033[?1049l");
+}
+
+struct workload {
+	const char *name;
+	void (*run) (struct sim *o);
+};
+
+static const struct workload cases[] = {
+	{ "top",      run_top },
+	{ "log",      run_log },
+	{ "progress", run_progress },
+	{ "editor",   run_editor },
+	{ NULL }
+};
+
+int main (void)
+{
+	static const int rates[] = { 0, 50, 10, 2 };
+	const struct workload *w;
+	struct sim o;
+	size_t i;
+
+	printf ("workload,rate,in_bytes,out_bytes,frames,ratio\n");
+
+	for (w = cases; w->name != NULL; ++w)
+		for (i = 0; i < sizeof (rates) / sizeof (rates[0]); ++i) {
+			if (!sim_init (&o, rates[i])) {
+				perror ("screen-test");
+				return 1;
+			}
+
+			rnd_state = 88172645463325252ull;
+			w->run (&o);
+
+			if (o.period > 0 && o.s.dirty)
+				sim_frame (&o, DURATION);
+
+			printf ("%s,%d,%lu,%lu,%lu,%.3f\n", w->name, rates[i],
+				o.in, o.out, o.frames, (double) o.out / o.in);
+			sim_fini (&o);
+		}
+
+	return 0;
+}
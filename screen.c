@@ -0,0 +1,738 @@
+/*
+ * Terminal Screen Model
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "screen.h"
+
+static struct cell *cell_at (struct screen *o, int row, int col)
+{
+	return o->cell + row * o->cols + col;
+}
+
+static void clear_cells (struct screen *o, struct cell *p, int count)
+{
+	struct cell blank = { ' ', { 0, o->attr.bg, 0 } };
+
+	for (; count > 0; --count)
+		*p++ = blank;
+}
+
+static void clear_rows (struct screen *o, int from, int to)
+{
+	clear_cells (o, cell_at (o, from, 0), (to - from) * o->cols);
+}
+
+static void scroll_up (struct screen *o, int top, int bottom, int n)
+{
+	int height = bottom - top + 1;
+
+	if (n > height)
+		n = height;
+
+	if (top == 0 && bottom == o->rows - 1)
+		o->scrolled += n;
+
+	memmove (cell_at (o, top, 0), cell_at (o, top + n, 0),
+		 (height - n) * o->cols * sizeof (o->cell[0]));
+	clear_rows (o, bottom + 1 - n, bottom + 1);
+	o->last = NULL;
+}
+
+static void scroll_down (struct screen *o, int top, int bottom, int n)
+{
+	int height = bottom - top + 1;
+
+	if (n > height)
+		n = height;
+
+	memmove (cell_at (o, top + n, 0), cell_at (o, top, 0),
+		 (height - n) * o->cols * sizeof (o->cell[0]));
+	clear_rows (o, top, top + n);
+	o->last = NULL;
+}
+
+static void linefeed (struct screen *o)
+{
+	if (o->row == o->bottom)
+		scroll_up (o, o->top, o->bottom, 1);
+	else if (o->row < o->rows - 1)
+		++o->row;
+
+	o->wrap = 0;
+}
+
+static void move_to (struct screen *o, int row, int col)
+{
+	o->row  = row < 0 ? 0 : row >= o->rows ? o->rows - 1 : row;
+	o->col  = col < 0 ? 0 : col >= o->cols ? o->cols - 1 : col;
+	o->wrap = 0;
+}
+
+static void put_byte (struct screen *o, int c)
+{
+	struct cell *p;
+	uint32_t ch;
+
+	if ((c & 0xc0) == 0x80) {		/* UTF-8 continuation */
+		if ((p = o->last) != NULL && (ch = p->ch) < 0x1000000)
+			p->ch |= c << (ch < 0x100 ? 8 : ch < 0x10000 ? 16 : 24);
+
+		return;
+	}
+
+	if (o->wrap) {
+		o->col = 0;
+		linefeed (o);
+	}
+
+	p = cell_at (o, o->row, o->col);
+	p->ch = c;
+	p->attr = o->attr;
+	o->last = p;
+
+	if (o->col < o->cols - 1)
+		++o->col;
+	else
+		o->wrap = 1;
+}
+
+static void on_print (void *cookie, const char *text, size_t len)
+{
+	struct screen *o = cookie;
+	const unsigned char *p = (const void *) text, *end = p + len;
+
+	for (; p < end; ++p)
+		put_byte (o, *p);
+
+	o->dirty = 1;
+}
+
+static void on_execute (void *cookie, int c)
+{
+	struct screen *o = cookie;
+
+	switch (c) {
+	case 010:				/* BS */
+		if (o->col > 0)
+			--o->col;
+
+		o->wrap = 0;
+		break;
+	case 011:				/* HT */
+		move_to (o, o->row, (o->col + 8) & ~7);
+		break;
+	case 012:				/* LF */
+	case 013:				/* VT */
+	case 014:				/* FF */
+		linefeed (o);
+		break;
+	case 015:				/* CR */
+		o->col  = 0;
+		o->wrap = 0;
+		break;
+	default:
+		return;
+	}
+
+	o->last  = NULL;
+	o->dirty = 1;
+}
+
+static void save_cursor (struct screen *o)
+{
+	o->saved_row  = o->row;
+	o->saved_col  = o->col;
+	o->saved_attr = o->attr;
+}
+
+static void restore_cursor (struct screen *o)
+{
+	move_to (o, o->saved_row, o->saved_col);
+	o->attr = o->saved_attr;
+}
+
+static void reset (struct screen *o)
+{
+	sgr_reset (&o->attr);
+	o->row = o->col = o->wrap = 0;
+	o->top = 0;
+	o->bottom = o->rows - 1;
+	o->hidden = 0;
+	o->in_alt = 0;
+	save_cursor (o);
+	clear_rows (o, 0, o->rows);
+}
+
+static void on_esc (void *cookie, const struct vt_seq *s)
+{
+	struct screen *o = cookie;
+
+	if (s->ninter > 0)
+		return;				/* charset designations */
+
+	switch (s->final) {
+	case 'D':				/* IND */
+		linefeed (o);
+		break;
+	case 'E':				/* NEL */
+		o->col = 0;
+		linefeed (o);
+		break;
+	case 'M':				/* RI */
+		if (o->row == o->top)
+			scroll_down (o, o->top, o->bottom, 1);
+		else if (o->row > 0)
+			--o->row;
+
+		o->wrap = 0;
+		break;
+	case '7':				/* DECSC */
+		save_cursor (o);
+		break;
+	case '8':				/* DECRC */
+		restore_cursor (o);
+		break;
+	case 'c':				/* RIS */
+		reset (o);
+		break;
+	default:
+		return;
+	}
+
+	o->last  = NULL;
+	o->dirty = 1;
+}
+
+static void set_alt (struct screen *o, int on)
+{
+	size_t size = o->rows * o->cols * sizeof (o->cell[0]);
+
+	if (o->in_alt == on)
+		return;
+
+	if (on)
+		memcpy (o->alt, o->cell, size);
+	else
+		memcpy (o->cell, o->alt, size);
+
+	if (on)
+		clear_rows (o, 0, o->rows);
+
+	o->in_alt = on;
+}
+
+static void set_mode (struct screen *o, const struct vt_seq *s, int on)
+{
+	int i;
+
+	for (i = 0; i < s->nparams; ++i)
+		switch (s->param[i]) {
+		case 25:
+			o->hidden = !on;
+			break;
+		case 47:
+		case 1047:
+			set_alt (o, on);
+			break;
+		case 1049:
+			if (on)
+				save_cursor (o);
+
+			set_alt (o, on);
+
+			if (!on)
+				restore_cursor (o);
+			break;
+		}
+}
+
+static void erase_display (struct screen *o, int mode)
+{
+	struct cell *p = cell_at (o, o->row, o->col);
+
+	switch (mode) {
+	case 0:
+		clear_cells (o, p, o->cell + o->rows * o->cols - p);
+		break;
+	case 1:
+		clear_cells (o, o->cell, p - o->cell + 1);
+		break;
+	default:
+		clear_rows (o, 0, o->rows);
+	}
+}
+
+static void erase_line (struct screen *o, int mode)
+{
+	struct cell *p = cell_at (o, o->row, 0);
+
+	switch (mode) {
+	case 0:
+		clear_cells (o, p + o->col, o->cols - o->col);
+		break;
+	case 1:
+		clear_cells (o, p, o->col + 1);
+		break;
+	default:
+		clear_cells (o, p, o->cols);
+	}
+}
+
+static void insert_chars (struct screen *o, int n)
+{
+	struct cell *p = cell_at (o, o->row, o->col);
+	int tail = o->cols - o->col;
+
+	if (n > tail)
+		n = tail;
+
+	memmove (p + n, p, (tail - n) * sizeof (*p));
+	clear_cells (o, p, n);
+}
+
+static void delete_chars (struct screen *o, int n)
+{
+	struct cell *p = cell_at (o, o->row, o->col);
+	int tail = o->cols - o->col;
+
+	if (n > tail)
+		n = tail;
+
+	memmove (p, p + n, (tail - n) * sizeof (*p));
+	clear_cells (o, p + tail - n, n);
+}
+
+static void erase_chars (struct screen *o, int n)
+{
+	int tail = o->cols - o->col;
+
+	clear_cells (o, cell_at (o, o->row, o->col), n < tail ? n : tail);
+}
+
+static void set_region (struct screen *o, int top, int bottom)
+{
+	if (bottom > o->rows)
+		bottom = o->rows;
+
+	if (top >= bottom)
+		return;
+
+	o->top    = top - 1;
+	o->bottom = bottom - 1;
+	move_to (o, 0, 0);
+}
+
+static void on_csi (void *cookie, const struct vt_seq *s)
+{
+	struct screen *o = cookie;
+	int n = vt_param (s, 0, 1);
+	int in_region = o->row >= o->top && o->row <= o->bottom;
+
+	if (s->mark == '?' && s->ninter == 0) {
+		if (s->final == 'h' || s->final == 'l')
+			set_mode (o, s, s->final == 'h');
+
+		o->dirty = 1;
+		return;
+	}
+
+	if (s->mark != 0 || s->ninter > 0)
+		return;
+
+	switch (s->final) {
+	case 'A':				/* CUU */
+		move_to (o, o->row - n < o->top && in_region ?
+			    o->top : o->row - n, o->col);
+		break;
+	case 'B':				/* CUD */
+	case 'e':				/* VPR */
+		move_to (o, o->row + n > o->bottom && in_region ?
+			    o->bottom : o->row + n, o->col);
+		break;
+	case 'C':				/* CUF */
+	case 'a':				/* HPR */
+		move_to (o, o->row, o->col + n);
+		break;
+	case 'D':				/* CUB */
+		move_to (o, o->row, o->col - n);
+		break;
+	case 'E':				/* CNL */
+		move_to (o, o->row + n, 0);
+		break;
+	case 'F':				/* CPL */
+		move_to (o, o->row - n, 0);
+		break;
+	case 'G':				/* CHA */
+	case '`':				/* HPA */
+		move_to (o, o->row, n - 1);
+		break;
+	case 'H':				/* CUP */
+	case 'f':				/* HVP */
+		move_to (o, n - 1, vt_param (s, 1, 1) - 1);
+		break;
+	case 'd':				/* VPA */
+		move_to (o, n - 1, o->col);
+		break;
+	case 'J':				/* ED */
+		erase_display (o, vt_param (s, 0, 0));
+		break;
+	case 'K':				/* EL */
+		erase_line (o, vt_param (s, 0, 0));
+		break;
+	case '@':				/* ICH */
+		insert_chars (o, n);
+		break;
+	case 'P':				/* DCH */
+		delete_chars (o, n);
+		break;
+	case 'X':				/* ECH */
+		erase_chars (o, n);
+		break;
+	case 'L':				/* IL */
+		if (in_region)
+			scroll_down (o, o->row, o->bottom, n);
+
+		o->col = 0;
+		break;
+	case 'M':				/* DL */
+		if (in_region)
+			scroll_up (o, o->row, o->bottom, n);
+
+		o->col = 0;
+		break;
+	case 'S':				/* SU */
+		scroll_up (o, o->top, o->bottom, n);
+		break;
+	case 'T':				/* SD */
+		scroll_down (o, o->top, o->bottom, n);
+		break;
+	case 'r':				/* DECSTBM */
+		set_region (o, vt_param (s, 0, 1), vt_param (s, 1, o->rows));
+		break;
+	case 'm':				/* SGR */
+		sgr_apply (&o->attr, s);
+		return;
+	case 's':				/* SCOSC */
+		save_cursor (o);
+		return;
+	case 'u':				/* SCORC */
+		restore_cursor (o);
+		break;
+	default:
+		return;
+	}
+
+	o->wrap  = 0;
+	o->last  = NULL;
+	o->dirty = 1;
+}
+
+static const struct vt_ops screen_ops = {
+	.print		= on_print,
+	.execute	= on_execute,
+	.esc		= on_esc,
+	.csi		= on_csi,
+};
+
+int screen_init (struct screen *o, int rows, int cols)
+{
+	size_t count = rows * cols;
+
+	o->rows = rows;
+	o->cols = cols;
+
+	if ((o->cell = malloc (count * sizeof (o->cell[0]))) == NULL)
+		return 0;
+
+	if ((o->alt = malloc (count * sizeof (o->cell[0]))) == NULL) {
+		free (o->cell);
+		return 0;
+	}
+
+	reset (o);
+	o->scrolled = 0;
+	o->dirty = 1;
+	o->last = NULL;
+	vt_parser_init (&o->parser, &screen_ops, o);
+	return 1;
+}
+
+void screen_fini (struct screen *o)
+{
+	free (o->cell);
+	free (o->alt);
+}
+
+static void copy_grid (struct cell *to, int rows, int cols,
+		       const struct cell *from, int from_rows, int from_cols)
+{
+	struct cell blank = { ' ' };
+	int row, col;
+
+	for (row = 0; row < rows; ++row)
+		for (col = 0; col < cols; ++col)
+			*to++ = row < from_rows && col < from_cols ?
+				from[row * from_cols + col] : blank;
+}
+
+int screen_resize (struct screen *o, int rows, int cols)
+{
+	size_t count = rows * cols;
+	struct cell *cell, *alt;
+
+	if (rows == o->rows && cols == o->cols)
+		return 1;
+
+	if ((cell = malloc (count * sizeof (cell[0]))) == NULL)
+		return 0;
+
+	if ((alt = malloc (count * sizeof (alt[0]))) == NULL) {
+		free (cell);
+		return 0;
+	}
+
+	copy_grid (cell, rows, cols, o->cell, o->rows, o->cols);
+	copy_grid (alt,  rows, cols, o->alt,  o->rows, o->cols);
+	screen_fini (o);
+
+	o->cell = cell;
+	o->alt  = alt;
+	o->rows = rows;
+	o->cols = cols;
+	o->top  = 0;
+	o->bottom = rows - 1;
+	move_to (o, o->row, o->col);
+	o->scrolled = 0;
+	o->dirty = 1;
+	o->last = NULL;
+	return 1;
+}
+
+void screen_write (struct screen *o, const char *data, size_t len)
+{
+	vt_parser_write (&o->parser, data, len);
+}
+
+/* Screen update */
+
+static int cell_equal (const struct cell *a, const struct cell *b)
+{
+	return a->ch == b->ch && sgr_equal (&a->attr, &b->attr);
+}
+
+static int cell_is_blank (const struct cell *o)
+{
+	return o->ch == ' ' && sgr_is_default (&o->attr);
+}
+
+static int add_csi (struct buffer *b, unsigned n, int final)
+{
+	return buffer_add (b, "\033[", 2) &&
+	       (n <= 1 || buffer_addu (b, n)) && buffer_addc (b, final);
+}
+
+static int move_peer (struct screen *peer, int row, int col, struct buffer *b)
+{
+	int ok;
+
+	if (peer->row == row && peer->col == col)
+		return 1;
+
+	if (peer->row == row && peer->col >= 0)
+		ok = col == 0 ? buffer_addc (b, '\r') :
+		     col > peer->col ? add_csi (b, col - peer->col, 'C') :
+				       add_csi (b, peer->col - col, 'D');
+	else if (peer->row >= 0 && row == peer->row + 1 && col == 0)
+		ok = buffer_add (b, "\r\n", 2);
+	else {
+		ok = buffer_add (b, "\033[", 2) &&
+		     ((row == 0 && col == 0) || buffer_addu (b, row + 1)) &&
+		     (col == 0 || (buffer_addc (b, ';') &&
+				   buffer_addu (b, col + 1))) &&
+		     buffer_addc (b, 'H');
+	}
+
+	peer->row = row;
+	peer->col = col;
+	return ok;
+}
+
+static int set_attr (struct screen *peer, const struct sgr_attr *a,
+		     struct buffer *b)
+{
+	if (sgr_equal (&peer->attr, a))
+		return 1;
+
+	peer->attr = *a;
+	return sgr_is_default (a) ? buffer_add (b, "\033[m", 3) :
+				    sgr_format (a, b);
+}
+
+static int put_cell (struct screen *peer, const struct cell *c,
+		     struct buffer *b)
+{
+	uint32_t ch;
+	int ok = set_attr (peer, &c->attr, b);
+
+	for (ch = c->ch; ok && ch != 0; ch >>= 8)
+		ok = buffer_addc (b, ch & 0xff);
+
+	*cell_at (peer, peer->row, peer->col) = *c;
+
+	if (++peer->col == peer->cols)
+		peer->row = peer->col = -1;	/* pending wrap: unknown */
+
+	return ok;
+}
+
+/* reprint short gap of unchanged cells s if it is cheaper than move */
+static int can_reprint (const struct cell *s, struct screen *peer, int row,
+			int col)
+{
+	int i;
+
+	if (peer->row != row || peer->col < 0 || col <= peer->col ||
+	    col - peer->col > 3)
+		return 0;
+
+	for (i = peer->col; i < col; ++i)
+		if (!sgr_equal (&s[i].attr, &peer->attr))
+			return 0;
+
+	return 1;
+}
+
+/* make row of peer show row from of screen */
+static int update_row (struct screen *o, int from, struct screen *peer,
+		       int row, struct buffer *b)
+{
+	const struct cell *s = cell_at (o, from, 0);
+	const struct cell *p = cell_at (peer, row, 0);
+	struct sgr_attr def;
+	int tail, col, ok = 1;
+
+	for (tail = o->cols; tail > 0 && cell_is_blank (s + tail - 1); --tail) {}
+
+	for (col = 0; ok && col < o->cols; ++col) {
+		if (cell_equal (s + col, p + col))
+			continue;
+
+		if (col >= tail) {
+			sgr_reset (&def);
+			ok = move_peer (peer, row, col, b) &&
+			     set_attr (peer, &def, b) &&
+			     buffer_add (b, "\033[K", 3);
+
+			memcpy (cell_at (peer, row, col), s + col,
+				(o->cols - col) * sizeof (*s));
+			break;
+		}
+
+		if (can_reprint (s, peer, row, col))
+			while (ok && peer->col < col)
+				ok = put_cell (peer, s + peer->col, b);
+		else
+			ok = move_peer (peer, row, col, b);
+
+		ok = ok && put_cell (peer, s + col, b);
+	}
+
+	return ok;
+}
+
+/*
+ * When cursor of receiver is on the bottom line, scroll it as program
+ * output does: every line that goes up is drawn at the bottom right
+ * before its line feed, thus scrolling text costs no more than raw
+ * output. Otherwise scroll up with SU and redraw new lines later.
+ */
+static int update_scroll (struct screen *o, struct screen *peer,
+			  struct buffer *b)
+{
+	struct sgr_attr def;
+	int bottom = peer->rows - 1, n = o->scrolled, ok = 1;
+
+	sgr_reset (&def);
+
+	if (peer->row == bottom)
+		for (; ok && n > 0; --n) {
+			ok = update_row (o, bottom - n, peer, bottom, b) &&
+			     move_peer (peer, bottom, 0, b) &&
+			     set_attr (peer, &def, b) && buffer_addc (b, '\n');
+
+			scroll_up (peer, 0, bottom, 1);
+		}
+	else {
+		ok = set_attr (peer, &def, b) && add_csi (b, n, 'S');
+		scroll_up (peer, 0, bottom, n);
+	}
+
+	peer->scrolled = 0;
+	return ok;
+}
+
+int screen_update (struct screen *o, struct screen *peer, struct buffer *b)
+{
+	int row, ok = 1;
+
+	if (peer->dirty) {
+		reset (peer);
+		ok = buffer_adds (b, "\033[m\033[?25h\033[H\033[2J");
+		peer->dirty = 0;
+	}
+	else if (o->scrolled > 0 && o->scrolled < o->rows)
+		ok = update_scroll (o, peer, b);
+
+	for (row = 0; ok && row < o->rows; ++row)
+		ok = update_row (o, row, peer, row, b);
+
+	ok = ok && move_peer (peer, o->row, o->col, b);
+
+	if (ok && peer->hidden != o->hidden) {
+		ok = buffer_adds (b, o->hidden ? "\033[?25l" : "\033[?25h");
+		peer->hidden = o->hidden;
+	}
+
+	o->scrolled = 0;
+	o->dirty = 0;
+	return ok;
+}
+
+/*
+ * Redraw from scratch through fresh peer, then restore state that the
+ * picture does not show, leaving screen update state untouched
+ */
+int screen_keyframe (struct screen *o, struct buffer *b)
+{
+	struct screen peer;
+	int scrolled = o->scrolled, dirty = o->dirty, ok;
+
+	if (!screen_init (&peer, o->rows, o->cols))
+		return 0;
+
+	ok = buffer_add (b, "\033[r", 3) && screen_update (o, &peer, b);
+
+	if (ok && (o->top > 0 || o->bottom < o->rows - 1)) {
+		/* setting region homes the cursor */
+		ok = buffer_add (b, "\033[", 2) &&
+		     buffer_addu (b, o->top + 1) && buffer_addc (b, ';') &&
+		     buffer_addu (b, o->bottom + 1) && buffer_addc (b, 'r');
+
+		peer.row = peer.col = 0;
+		ok = ok && move_peer (&peer, o->row, o->col, b);
+	}
+
+	ok = ok && set_attr (&peer, &o->attr, b);
+
+	o->scrolled = scrolled;
+	o->dirty = dirty;
+	screen_fini (&peer);
+	return ok;
+}
@@ -0,0 +1,72 @@
+/*
+ * Terminal Screen Model
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef SCREEN_H
+#define SCREEN_H  1
+
+#include <stdint.h>
+
+#include "buffer.h"
+#include "sgr.h"
+#include "vt-parser.h"
+
+/*
+ * Cell character is stored as UTF-8 sequence packed into integer, first
+ * byte in the lowest octet. Characters are assumed to be single width.
+ */
+struct cell {
+	uint32_t ch;
+	struct sgr_attr attr;
+};
+
+struct screen {
+	int rows, cols;
+	struct cell *cell;
+	int row, col, wrap;		/* cursor and pending wrap flag */
+	int top, bottom;		/* scrolling region */
+	int saved_row, saved_col;
+	struct sgr_attr attr, saved_attr;
+	int hidden;			/* cursor is not visible */
+	int scrolled;			/* full-screen scrolls since update */
+	int dirty;			/* changed since last update */
+	struct cell *last;		/* target for UTF-8 continuation */
+	struct cell *alt;		/* saved main screen */
+	int in_alt;			/* alternate screen is active */
+	struct vt_parser parser;
+};
+
+int  screen_init (struct screen *o, int rows, int cols);
+void screen_fini (struct screen *o);
+
+/*
+ * Change size keeping top left part of contents, cursor is moved inside
+ * and scrolling region is reset. Returns zero on out of memory, screen
+ * is left intact then.
+ */
+int screen_resize (struct screen *o, int rows, int cols);
+
+/* feed output of program into screen model */
+void screen_write (struct screen *o, const char *data, size_t len);
+
+/*
+ * Append minimal sequence that transforms peer (what the receiver shows)
+ * into screen, update peer accordingly, reset dirty flag and scroll
+ * counter. Peer size must match. Dirty peer means that receiver contents
+ * is unknown, thus it is cleared and redrawn, as on the first update.
+ */
+int screen_update (struct screen *o, struct screen *peer, struct buffer *b);
+
+/*
+ * Append sequence that draws screen on a terminal in any state and sets
+ * scrolling region, cursor and current attributes, so that following
+ * program output renders as it did here. Alternate screen contents and
+ * modes other than cursor visibility are not restored.
+ */
+int screen_keyframe (struct screen *o, struct buffer *b);
+
+#endif  /* SCREEN_H */
@@ -0,0 +1,122 @@
+/*
+ * Select Graphic Rendition Attributes
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "sgr.h"
+
+/*
+ * Parse extended color: 5;index or 2;r;g;b, returns number of
+ * parameters consumed after the selector
+ */
+static int sgr_color (uint32_t *color, const struct vt_seq *s, int i)
+{
+	int r, g, b;
+
+	switch (vt_param (s, i, 0)) {
+	case 5:
+		if (i + 1 < s->nparams)
+			*color = (vt_param (s, i + 1, 0) & 0xff) + 1;
+
+		return 2;
+	case 2:
+		r = vt_param (s, i + 1, 0) & 0xff;
+		g = vt_param (s, i + 2, 0) & 0xff;
+		b = vt_param (s, i + 3, 0) & 0xff;
+
+		if (i + 3 < s->nparams)
+			*color = SGR_RGB | r << 16 | g << 8 | b;
+
+		return 4;
+	}
+
+	return 1;
+}
+
+void sgr_apply (struct sgr_attr *o, const struct vt_seq *s)
+{
+	int i, x;
+
+	if (s->nparams == 0) {
+		sgr_reset (o);
+		return;
+	}
+
+	for (i = 0; i < s->nparams; ++i)
+		switch ((x = vt_param (s, i, 0))) {
+		case 0:  sgr_reset (o);				break;
+		case 1:  o->flags |= SGR_BOLD;			break;
+		case 2:  o->flags |= SGR_DIM;			break;
+		case 3:  o->flags |= SGR_ITALIC;		break;
+		case 4:  o->flags |= SGR_UNDERLINE;		break;
+		case 5:  o->flags |= SGR_BLINK;			break;
+		case 7:  o->flags |= SGR_REVERSE;		break;
+		case 8:  o->flags |= SGR_HIDDEN;		break;
+		case 9:  o->flags |= SGR_STRIKE;		break;
+		case 22: o->flags &= ~(SGR_BOLD | SGR_DIM);	break;
+		case 23: o->flags &= ~SGR_ITALIC;		break;
+		case 24: o->flags &= ~SGR_UNDERLINE;		break;
+		case 25: o->flags &= ~SGR_BLINK;		break;
+		case 27: o->flags &= ~SGR_REVERSE;		break;
+		case 28: o->flags &= ~SGR_HIDDEN;		break;
+		case 29: o->flags &= ~SGR_STRIKE;		break;
+		case 38: i += sgr_color (&o->fg, s, i + 1);	break;
+		case 39: o->fg = 0;				break;
+		case 48: i += sgr_color (&o->bg, s, i + 1);	break;
+		case 49: o->bg = 0;				break;
+		default:
+			if (x >= 30 && x <= 37)
+				o->fg = x - 30 + 1;
+			else if (x >= 40 && x <= 47)
+				o->bg = x - 40 + 1;
+			else if (x >= 90 && x <= 97)
+				o->fg = x - 90 + 8 + 1;
+			else if (x >= 100 && x <= 107)
+				o->bg = x - 100 + 8 + 1;
+		}
+}
+
+static int add_param (struct buffer *b, unsigned x)
+{
+	return buffer_addc (b, ';') && buffer_addu (b, x);
+}
+
+static int add_color (struct buffer *b, uint32_t color, int base)
+{
+	unsigned i = color - 1;
+
+	if ((color & SGR_RGB) != 0)
+		return add_param (b, base + 8) && add_param (b, 2) &&
+		       add_param (b, (color >> 16) & 0xff) &&
+		       add_param (b, (color >> 8) & 0xff) &&
+		       add_param (b, color & 0xff);
+
+	if (i < 8)
+		return add_param (b, base + i);
+
+	if (i < 16)
+		return add_param (b, base + 60 + i - 8);
+
+	return add_param (b, base + 8) && add_param (b, 5) && add_param (b, i);
+}
+
+int sgr_format (const struct sgr_attr *o, struct buffer *b)
+{
+	static const unsigned char code[] = { 1, 2, 3, 4, 5, 7, 8, 9 };
+	int i, ok = buffer_add (b, "\033[0", 3);
+
+	for (i = 0; ok && i < sizeof (code); ++i)
+		if ((o->flags & (1 << i)) != 0)
+			ok = add_param (b, code[i]);
+
+	if (ok && o->fg != 0)
+		ok = add_color (b, o->fg, 30);
+
+	if (ok && o->bg != 0)
+		ok = add_color (b, o->bg, 40);
+
+	return ok && buffer_addc (b, 'm');
+}
@@ -0,0 +1,60 @@
+/*
+ * Select Graphic Rendition Attributes
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef SGR_H
+#define SGR_H  1
+
+#include <stdint.h>
+
+#include "buffer.h"
+#include "vt-parser.h"
+
+enum sgr_flags {
+	SGR_BOLD	= 1 << 0,
+	SGR_DIM		= 1 << 1,
+	SGR_ITALIC	= 1 << 2,
+	SGR_UNDERLINE	= 1 << 3,
+	SGR_BLINK	= 1 << 4,
+	SGR_REVERSE	= 1 << 5,
+	SGR_HIDDEN	= 1 << 6,
+	SGR_STRIKE	= 1 << 7,
+};
+
+/*
+ * Color encoding: zero is the default color, 1-256 is palette index
+ * plus one, SGR_RGB bit marks direct 24-bit color.
+ */
+#define SGR_RGB		0x1000000
+
+struct sgr_attr {
+	uint32_t fg, bg;
+	uint32_t flags;
+};
+
+static inline void sgr_reset (struct sgr_attr *o)
+{
+	o->fg = o->bg = o->flags = 0;
+}
+
+static inline int sgr_equal (const struct sgr_attr *a, const struct sgr_attr *b)
+{
+	return a->fg == b->fg && a->bg == b->bg && a->flags == b->flags;
+}
+
+static inline int sgr_is_default (const struct sgr_attr *o)
+{
+	return (o->fg | o->bg | o->flags) == 0;
+}
+
+/* apply parameters of SGR control sequence */
+void sgr_apply (struct sgr_attr *o, const struct vt_seq *s);
+
+/* append SGR sequence that sets attributes from scratch */
+int sgr_format (const struct sgr_attr *o, struct buffer *b);
+
+#endif  /* SGR_H */
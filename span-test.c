@@ -0,0 +1,154 @@
+/*
+ * ANSI to Attributed Text Spans Converter Benchmark
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "span.h"
+
+#define CHUNK  (512 * 32)	/* span filter read size */
+#define MiB    (1024 * 1024)
+#define TOTAL  64		/* MiB per format */
+
+static long long clock_ns (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* colored compiler diagnostics, as gcc prints them to a terminal */
+static int make_diag (struct buffer *b, size_t size)
+{
+	static const char *kind[] = {
+		"\033[01;35m\033[Kwarning: ", "\033[01;31m\033[Kerror: ",
+		"\033[01;36m\033[Knote: ",
+	};
+	unsigned i;
+	int ok = 1;
+
+	for (i = 0; ok && b->len < size; ++i)
+		ok = buffer_adds (b, "\033[01m\033[Ksrc/relay.c:") &&
+		     buffer_addu (b, 100 + i % 900) && buffer_addc (b, ':') &&
+		     buffer_addu (b, 1 + i % 60) &&
+		     buffer_adds (b, ":\033[m\033[K ") &&
+		     buffer_adds (b, kind[i % 3]) &&
+		     buffer_adds (b, "\033[m\033[Kunused variable \xe2\x80\x98"
+				     "\033[01m\033[Kcount\033[m\033[K"
+				     "\xe2\x80\x99 [\033[01;35m\033[K"
+				     "-Wunused-variable"
+				     "\033[m\033[K]\n  ") &&
+		     buffer_addu (b, 100 + i % 900) &&
+		     buffer_adds (b, " |   size_t \033[01;35m\033[Kcount\033[m"
+				     "\033[K = \"<a & b>\";\n      |"
+				     "          \033[01;35m\033[K^~~~~\033[m"
+				     "\033[K\n");
+
+	return ok;
+}
+
+/* build log: mostly plain text with a colored word now and then */
+static int make_build (struct buffer *b, size_t size)
+{
+	unsigned i;
+	int ok = 1;
+
+	for (i = 0; ok && b->len < size; ++i)
+		ok = buffer_adds (b, i % 16 == 0 ? "\033[32m  CC\033[0m      " :
+						 "  CC      ") &&
+		     buffer_adds (b, "drivers/net/ethernet/vendor/module-") &&
+		     buffer_addu (b, i) &&
+		     buffer_adds (b, ".o\n  LD [M]  drivers/net/ethernet/"
+				     "vendor/module.ko \xe2\x80\x94 done\n");
+
+	return ok;
+}
+
+static int run (int format, const struct buffer *in, double *time,
+		size_t *out_len)
+{
+	struct span_conv s;
+	struct buffer out;
+	size_t total = (size_t) TOTAL * MiB, pos, n;
+	long long start;
+	int ok = 1;
+
+	span_init (&s, format);
+	buffer_init (&out);
+
+	*out_len = 0;
+	start = clock_ns ();
+
+	for (pos = 0; ok && pos < total; pos += n) {
+		n = in->len - pos % in->len;
+		n = n < CHUNK ? n : CHUNK;
+
+		buffer_reset (&out);
+		ok = span_write (&s, in->data + pos % in->len, n, &out);
+		*out_len += out.len;
+	}
+
+	buffer_reset (&out);
+	ok = ok && span_flush (&s, &out);
+	*out_len += out.len;
+	*time = (clock_ns () - start) / 1e9;
+
+	buffer_fini (&out);
+	span_fini (&s);
+	return ok;
+}
+
+struct input {
+	const char *name;
+	int (*make) (struct buffer *b, size_t size);
+};
+
+static const struct input cases[] = {
+	{ "diag",  make_diag },
+	{ "build", make_build },
+	{ NULL }
+};
+
+int main (void)
+{
+	static const char *name[] = { "json", "html" };
+	const struct input *c;
+	struct buffer in;
+	size_t out_len;
+	double time;
+	int i;
+
+	printf ("input,format,mib,time_s,mb_s,out_ratio\n");
+
+	for (c = cases; c->name != NULL; ++c) {
+		buffer_init (&in);
+
+		if (!c->make (&in, MiB)) {
+			perror ("span-test");
+			return 1;
+		}
+
+		for (i = 0; i < 2; ++i) {
+			if (!run (i == 0 ? SPAN_JSON : SPAN_HTML, &in, &time,
+				  &out_len)) {
+				perror ("span-test");
+				return 1;
+			}
+
+			printf ("%s,%s,%d,%.3f,%.1f,%.2f\n", c->name, name[i],
+				TOTAL, time, TOTAL * (double) MiB / 1e6 / time,
+				(double) out_len / ((double) TOTAL * MiB));
+			fflush (stdout);
+		}
+
+		buffer_fini (&in);
+	}
+
+	return 0;
+}
@@ -0,0 +1,298 @@
+/*
+ * ANSI to Attributed Text Spans Converter
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "span.h"
+
+enum span_state { SPAN_NONE, SPAN_PLAIN, SPAN_TAG };
+
+static const char *flag_name[] = {
+	"bold", "dim", "italic", "underline",
+	"blink", "reverse", "hidden", "strike",
+};
+
+static uint32_t palette_rgb (unsigned i)
+{
+	static const uint32_t base[16] = {
+		0x000000, 0xcd0000, 0x00cd00, 0xcdcd00,
+		0x0000ee, 0xcd00cd, 0x00cdcd, 0xe5e5e5,
+		0x7f7f7f, 0xff0000, 0x00ff00, 0xffff00,
+		0x5c5cff, 0xff00ff, 0x00ffff, 0xffffff,
+	};
+	static const unsigned char level[6] = {
+		0x00, 0x5f, 0x87, 0xaf, 0xd7, 0xff,
+	};
+	unsigned g;
+
+	if (i < 16)
+		return base[i];
+
+	if (i < 232) {
+		i -= 16;
+		return level[i / 36] << 16 | level[i / 6 % 6] << 8 |
+		       level[i % 6];
+	}
+
+	g = 8 + (i - 232) * 10;
+	return g << 16 | g << 8 | g;
+}
+
+static int add_rgb (struct buffer *b, uint32_t rgb)
+{
+	static const char hex[] = "0123456789abcdef";
+	char buf[7];
+	int i;
+
+	buf[0] = '#';
+
+	for (i = 6; i > 0; --i, rgb >>= 4)
+		buf[i] = hex[rgb & 0xf];
+
+	return buffer_add (b, buf, sizeof (buf));
+}
+
+static int json_color (struct buffer *b, const char *name, uint32_t color)
+{
+	int ok = buffer_addc (b, '"') && buffer_adds (b, name) &&
+		 buffer_add (b, "\":", 2);
+
+	if ((color & SGR_RGB) == 0)
+		return ok && buffer_addu (b, color - 1) && buffer_addc (b, ',');
+
+	return ok && buffer_addc (b, '"') && add_rgb (b, color & 0xffffff) &&
+	       buffer_add (b, "\",", 2);
+}
+
+static int json_open (struct span_conv *o)
+{
+	struct buffer *b = o->out;
+	int i, ok = buffer_addc (b, '{');
+
+	if (ok && o->attr.fg != 0)
+		ok = json_color (b, "fg", o->attr.fg);
+
+	if (ok && o->attr.bg != 0)
+		ok = json_color (b, "bg", o->attr.bg);
+
+	for (i = 0; ok && i < 8; ++i)
+		if ((o->attr.flags & (1 << i)) != 0)
+			ok = buffer_addc (b, '"') &&
+			     buffer_adds (b, flag_name[i]) &&
+			     buffer_add (b, "\":true,", 7);
+
+	o->open = SPAN_TAG;
+	return ok && buffer_add (b, "\"text\":\"", 8);
+}
+
+static int css_color (struct buffer *b, const char *prop, uint32_t color,
+		      const char *def)
+{
+	int ok = buffer_adds (b, prop) && buffer_addc (b, ':');
+
+	if (color == 0)
+		ok = ok && buffer_adds (b, def);
+	else
+		ok = ok && add_rgb (b, (color & SGR_RGB) != 0 ?
+				       color & 0xffffff :
+				       palette_rgb (color - 1));
+
+	return ok && buffer_addc (b, ';');
+}
+
+static int html_open (struct span_conv *o)
+{
+	const struct sgr_attr *a = &o->attr;
+	struct buffer *b = o->out;
+	uint32_t fg = a->fg, bg = a->bg;
+	int ok = 1;
+
+	if (sgr_is_default (a)) {
+		o->open = SPAN_PLAIN;
+		return 1;
+	}
+
+	if ((a->flags & SGR_REVERSE) != 0) {
+		fg = a->bg;
+		bg = a->fg;
+	}
+
+	ok = buffer_adds (b, "<span style=\"");
+
+	if (ok && (fg != 0 || (a->flags & SGR_REVERSE) != 0))
+		ok = css_color (b, "color", fg, "Canvas");
+
+	if (ok && (bg != 0 || (a->flags & SGR_REVERSE) != 0))
+		ok = css_color (b, "background", bg, "CanvasText");
+
+	if (ok && (a->flags & SGR_BOLD) != 0)
+		ok = buffer_adds (b, "font-weight:bold;");
+
+	if (ok && (a->flags & SGR_DIM) != 0)
+		ok = buffer_adds (b, "opacity:.5;");
+
+	if (ok && (a->flags & SGR_ITALIC) != 0)
+		ok = buffer_adds (b, "font-style:italic;");
+
+	if (ok && (a->flags & (SGR_UNDERLINE | SGR_STRIKE)) != 0)
+		ok = buffer_adds (b, "text-decoration:") &&
+		     ((a->flags & SGR_UNDERLINE) == 0 ||
+		      buffer_adds (b, " underline")) &&
+		     ((a->flags & SGR_STRIKE) == 0 ||
+		      buffer_adds (b, " line-through")) &&
+		     buffer_addc (b, ';');
+
+	if (ok && (a->flags & SGR_HIDDEN) != 0)
+		ok = buffer_adds (b, "visibility:hidden;");
+
+	o->open = SPAN_TAG;
+	return ok && buffer_add (b, "\">", 2);
+}
+
+static void span_open (struct span_conv *o)
+{
+	if (o->open != SPAN_NONE)
+		return;
+
+	o->ok = o->ok && (o->format == SPAN_JSON ? json_open (o) :
+						  html_open (o));
+}
+
+static void span_close (struct span_conv *o)
+{
+	if (o->open == SPAN_TAG)
+		o->ok = o->ok && (o->format == SPAN_JSON ?
+				  buffer_add (o->out, "\"}\n", 3) :
+				  buffer_add (o->out, "</span>", 7));
+
+	o->open = SPAN_NONE;
+}
+
+static int is_special (int format, int c)
+{
+	return format == SPAN_JSON ? c == '"' || c == '\\' :
+				     c == '<' || c == '>' || c == '&';
+}
+
+static const char *escape (int c)
+{
+	switch (c) {
+	case '"':	return "\\\"";
+	case '\\':	return "\\\\";
+	case '<':	return "&lt;";
+	case '>':	return "&gt;";
+	default:	return "&amp;";
+	}
+}
+
+static void on_print (void *cookie, const char *text, size_t len)
+{
+	struct span_conv *o = cookie;
+	const char *end = text + len, *p;
+
+	span_open (o);
+
+	while (o->ok && text < end) {
+		for (p = text; p < end && !is_special (o->format, *p); ++p) {}
+
+		o->ok = buffer_add (o->out, text, p - text);
+
+		if (p == end)
+			break;
+
+		o->ok = o->ok && buffer_adds (o->out, escape (*p));
+		text = p + 1;
+	}
+}
+
+static void on_execute (void *cookie, int c)
+{
+	struct span_conv *o = cookie;
+	const char *json;
+
+	switch (c) {
+	case '\t':	json = "\\t";	break;
+	case '\n':	json = "\\n";	break;
+	case '\r':	json = "\\r";	break;
+	default:
+		return;
+	}
+
+	span_open (o);
+
+	if (o->format == SPAN_JSON)
+		o->ok = o->ok && buffer_add (o->out, json, 2);
+	else
+		o->ok = o->ok && buffer_addc (o->out, c);
+
+	if (c == '\n' && o->format == SPAN_JSON)
+		span_close (o);
+}
+
+static void on_csi (void *cookie, const struct vt_seq *s)
+{
+	struct span_conv *o = cookie;
+	struct sgr_attr a = o->attr;
+
+	if (s->final != 'm' || s->mark != 0 || s->ninter != 0)
+		return;
+
+	sgr_apply (&a, s);
+
+	if (!sgr_equal (&a, &o->attr)) {
+		span_close (o);
+		o->attr = a;
+	}
+}
+
+static const struct vt_ops span_ops = {
+	.print		= on_print,
+	.execute	= on_execute,
+	.csi		= on_csi,
+};
+
+void span_init (struct span_conv *o, int format)
+{
+	o->format = format;
+	o->open   = SPAN_NONE;
+	sgr_reset (&o->attr);
+	vt_parser_init (&o->parser, &span_ops, o);
+	utf8_init (&o->u);
+	buffer_init (&o->in);
+}
+
+void span_fini (struct span_conv *o)
+{
+	buffer_fini (&o->in);
+}
+
+int span_write (struct span_conv *o, const char *data, size_t len,
+		struct buffer *out)
+{
+	o->out = out;
+	buffer_reset (&o->in);
+
+	if (!utf8_write (&o->u, data, len, &o->in))
+		return 0;
+
+	o->ok = 1;
+	vt_parser_write (&o->parser, o->in.data, o->in.len);
+	return o->ok;
+}
+
+int span_flush (struct span_conv *o, struct buffer *out)
+{
+	o->out = out;
+	buffer_reset (&o->in);
+
+	if (!utf8_flush (&o->u, &o->in))
+		return 0;
+
+	o->ok = 1;
+	vt_parser_write (&o->parser, o->in.data, o->in.len);
+	span_close (o);
+	return o->ok;
+}
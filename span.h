@@ -0,0 +1,47 @@
+/*
+ * ANSI to Attributed Text Spans Converter
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef SPAN_H
+#define SPAN_H  1
+
+#include "buffer.h"
+#include "sgr.h"
+#include "utf8.h"
+#include "vt-parser.h"
+
+enum span_format {
+	SPAN_JSON,	/* one JSON object per span, one span per line */
+	SPAN_HTML,	/* HTML fragment with inline styles */
+};
+
+struct span_conv {
+	int format, open, ok;
+	struct sgr_attr attr;
+	struct buffer *out;
+	struct vt_parser parser;
+	struct utf8_filter u;
+	struct buffer in;		/* chunk with valid UTF-8 */
+};
+
+void span_init (struct span_conv *o, int format);
+void span_fini (struct span_conv *o);
+
+/*
+ * Convert next chunk of program output and append result to buffer.
+ * Escape sequences and characters may be split between chunks: span is
+ * left open at the end of chunk, incomplete UTF-8 sequence is kept for
+ * the next one. Invalid UTF-8 is replaced with U+FFFD, thus JSON and
+ * HTML produced stay valid. Returns zero on out of memory.
+ */
+int span_write (struct span_conv *o, const char *data, size_t len,
+		struct buffer *out);
+
+/* append kept bytes and close span at end of stream */
+int span_flush (struct span_conv *o, struct buffer *out);
+
+#endif  /* SPAN_H */
@@ -0,0 +1,115 @@
+/*
+ * Line Timestamp Stage
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+
+#include "stamp.h"
+
+void stamp_init (struct stamp *o, int clock)
+{
+	o->clock = clock;
+	o->bol   = 1;
+	o->sec   = -1;
+	o->ms    = -1;
+
+	clock_gettime (CLOCK_MONOTONIC, &o->start);
+}
+
+static void render (struct stamp *o, time_t sec)
+{
+	struct tm tm;
+	int n;
+
+	if (o->clock == STAMP_WALL) {
+		localtime_r (&sec, &tm);
+		n = strftime (o->prefix, sizeof (o->prefix),
+			      "%Y-%m-%d %H:%M:%S.", &tm);
+	}
+	else
+		n = snprintf (o->prefix, sizeof (o->prefix) - 5, "[%6lld.",
+			      (long long) sec);
+
+	o->ms_pos = n;
+	o->len    = n + 3;
+
+	if (o->clock == STAMP_WALL)
+		o->prefix[o->len++] = ' ';
+	else {
+		o->prefix[o->len++] = ']';
+		o->prefix[o->len++] = ' ';
+	}
+}
+
+static void stamp_update (struct stamp *o)
+{
+	struct timespec ts;
+	char *p;
+	int ms;
+
+	if (o->clock == STAMP_WALL)
+		clock_gettime (CLOCK_REALTIME, &ts);
+	else {
+		clock_gettime (CLOCK_MONOTONIC, &ts);
+
+		ts.tv_sec  -= o->start.tv_sec;
+		ts.tv_nsec -= o->start.tv_nsec;
+
+		if (ts.tv_nsec < 0) {
+			--ts.tv_sec;
+			ts.tv_nsec += 1000000000;
+		}
+	}
+
+	ms = ts.tv_nsec / 1000000;
+
+	if (ts.tv_sec != o->sec) {
+		render (o, ts.tv_sec);
+		o->sec = ts.tv_sec;
+		o->ms  = -1;
+	}
+
+	if (ms != o->ms) {
+		p = o->prefix + o->ms_pos;
+		p[0] = '0' + ms / 100;
+		p[1] = '0' + ms / 10 % 10;
+		p[2] = '0' + ms % 10;
+		o->ms = ms;
+	}
+}
+
+/*
+ * All lines of a chunk arrived at once, so clock is read once per chunk.
+ * Line ends are found with memchr, which is vectorized in libc.
+ */
+int stamp_write (struct stamp *o, const char *data, size_t len,
+		 struct buffer *out)
+{
+	const char *end = data + len, *p;
+
+	if (len == 0)
+		return 1;
+
+	stamp_update (o);
+
+	for (; data < end; data = p) {
+		if (o->bol && !buffer_add (out, o->prefix, o->len))
+			return 0;
+
+		if ((p = memchr (data, '\n', end - data)) != NULL)
+			++p;
+		else
+			p = end;
+
+		o->bol = p[-1] == '\n';
+
+		if (!buffer_add (out, data, p - data))
+			return 0;
+	}
+
+	return 1;
+}
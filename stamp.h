@@ -0,0 +1,41 @@
+/*
+ * Line Timestamp Stage
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef STAMP_H
+#define STAMP_H  1
+
+#include <time.h>
+
+#include "buffer.h"
+
+enum stamp_clock {
+	STAMP_WALL,	/* local time: YYYY-MM-DD hh:mm:ss.mmm */
+	STAMP_ELAPSED,	/* seconds since start: [ssssss.mmm] */
+};
+
+/*
+ * Every line is prefixed with time of arrival of its first byte. The
+ * prefix is rendered once per second, only milliseconds are patched in
+ * between.
+ */
+struct stamp {
+	int clock, bol;
+	struct timespec start;
+	time_t sec;
+	int ms;
+	size_t len, ms_pos;
+	char prefix[48];
+};
+
+void stamp_init (struct stamp *o, int clock);
+
+/* prefix lines of next chunk and append result to buffer */
+int stamp_write (struct stamp *o, const char *data, size_t len,
+		 struct buffer *out);
+
+#endif  /* STAMP_H */
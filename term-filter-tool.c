@@ -1,15 +1,41 @@
+#define _GNU_SOURCE
+
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
 #include <sys/wait.h>
 
 #include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
 #include <termios.h>
 #include <unistd.h>
 
+#include "answer.h"
+#include "c11-atomics.h"
 #include "c11-threads.h"
+#include "lockfree.h"
+#include "logger.h"
+#include "paste.h"
+#include "pool.h"
+#include "pty.h"
+#include "record.h"
+#include "redact.h"
+#include "ring.h"
+#include "screen.h"
+#include "span.h"
+#include "stamp.h"
+#include "trigger.h"
+#include "tune.h"
+#include "utf8.h"
+#include "vt-parser.h"
 
 static ssize_t safe_read (int fd, void *buf, size_t count)
 {
@@ -26,7 +52,7 @@ static ssize_t safe_write (int fd, const void *buf, size_t count)
 	const char *p;
 
 	for (p = buf, avail = count; avail > 0; p += n, avail -= n) {
-		while ((n = write (fd, p, count)) < 0 && errno == EINTR) {}
+		while ((n = write (fd, p, avail)) < 0 && errno == EINTR) {}
 
 		if (n < 0)
 			return n;
@@ -36,139 +62,1755 @@ static ssize_t safe_write (int fd, const void *buf, size_t count)
 }
 
 #define BUFSIZE  512
+#define RINGSIZE  65536
+#define STACKSIZE  (64 * 1024)	/* relay threads need a few buffers only */
+#define YIELDTIME  10000	/* max output delay for pending input, us */
+#define YIELDSIZE  256		/* output batch size while input pending */
+#define BURSTSIZE  64		/* more queued input is a paste */
+#define PACESIZE   512		/* paste chunk size */
+#define PACEFILL   (4096 - PACESIZE)	/* pty input queue is 4 KiB */
+#define PACETIME   100000	/* max wait for pty input queue, us */
+#define DRAINTIME  500		/* max wait for output after exit, ms */
+#define WINCHQUIET 50		/* apply resize after quiet time, ms */
+#define WINCHHOLD  4		/* but hold it no more than 4 quiet times */
+#define LINESIZE   4096		/* longer job output lines are split */
+#define REDACTTIME 50		/* max hold of secret prefix on idle, ms */
+#define TEXTCOUNT  64		/* max rule texts queued to input relay */
+
+enum format { FORMAT_TEXT, FORMAT_DIFF, FORMAT_JSON, FORMAT_HTML };
+
+/*
+ * User input passed to writer thread is counted in bytes from the start:
+ * keystroke is pending until writer count passes it, signal character
+ * makes writer drop everything queued before it.
+ *
+ * Texts sent by output rules are passed to input relay and queued there
+ * as user input, thus output relay never blocks on writes to program.
+ */
+struct input_queue {
+	atomic_size_t queued;		/* passed to writer */
+	atomic_size_t written;		/* written or dropped by writer */
+	atomic_size_t key;		/* queued count at last keystroke end */
+	atomic_size_t drop;		/* queued count at last signal */
+	struct eventcount passed;	/* written count grows */
+	struct spsc_queue texts;	/* of struct input_text */
+	int wake;			/* eventfd signaled on text or -1 */
+};
+
+struct input_text {
+	size_t len;
+	char data[];
+};
 
-static void no_filter (int in, int out)
+static int input_queue_init (struct input_queue *o, int texts)
 {
-	char buf[BUFSIZE];
+	atomic_init (&o->queued,  0);
+	atomic_init (&o->written, 0);
+	atomic_init (&o->key,     0);
+	atomic_init (&o->drop,    0);
+	o->wake = -1;
+
+	if (!eventcount_init (&o->passed))
+		return 0;
+
+	if (!texts)
+		return 1;
+
+	if (!spsc_init (&o->texts, TEXTCOUNT))
+		goto no_texts;
+
+	if ((o->wake = eventfd (0, EFD_CLOEXEC)) < 0)
+		goto no_wake;
+
+	return 1;
+no_wake:
+	spsc_fini (&o->texts);
+no_texts:
+	eventcount_fini (&o->passed);
+	return 0;
+}
+
+/* counters are free-running, compare them by difference */
+static int input_key_pending (struct input_queue *o)
+{
+	return (ptrdiff_t) (atomic_load (&o->key) -
+			    atomic_load (&o->written)) > 0;
+}
+
+struct relay {
+	int in, out;
+	int format, rate;
+	int utf8;			/* validate output */
+	int clock;			/* prefix lines, -1 for none */
+	struct utf8_filter u;
+	struct stamp s;
+	struct buffer ub, sb, xb;
+	int spin;			/* busy-poll window, us */
+	int input;			/* relay carries user input */
+	struct input_queue *queue;	/* user input not written yet */
+	int pace;			/* pace pastes by program reading */
+	struct paste paste;
+	int slave;			/* open during paste, -1 otherwise */
+	int answer;			/* reply to terminal queries */
+	struct answer a;
+	struct buffer ab;
+	struct recorder *rec;		/* session record or NULL */
+	struct logger *log;		/* copy of output or NULL */
+	struct redact *redact;		/* secret masking or NULL */
+	struct trigger *trigger;	/* output rules or NULL */
+	struct buffer tb;		/* texts of fired rules */
+	long long idle;			/* since last read, ms */
+	int done;			/* eventfd signaled twice at end or -1 */
+	int winch;			/* eventfd signaled on resize or -1 */
+	int stop;			/* eventfd: stop reading input, or -1 */
+	int piped;			/* writes go through ring */
+	struct ring ring;
+	thrd_t writer;
+};
+
+static long long clock_us (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static void get_size (int *rows, int *cols)
+{
+	struct winsize ws;
+
+	if ((ioctl (1, TIOCGWINSZ, &ws) == 0 ||
+	     ioctl (0, TIOCGWINSZ, &ws) == 0) &&
+	    ws.ws_row > 0 && ws.ws_col > 0) {
+		*rows = ws.ws_row;
+		*cols = ws.ws_col;
+	}
+	else {
+		*rows = 24;
+		*cols = 80;
+	}
+}
+
+/*
+ * Output gives way to user input: while a keystroke is pending it waits
+ * for input writer to write it out, and goes on with small batches only
+ * if it is still pending. Wait is bounded, as program may not read its
+ * input until its output is drained. Paste backlog is not waited for.
+ */
+static size_t output_yield (struct relay *o, size_t count)
+{
+	struct input_queue *q = o->queue;
+	struct timespec deadline;
+	unsigned key;
+
+	if (o->input || !input_key_pending (q))
+		return count;
+
+	clock_gettime (CLOCK_MONOTONIC, &deadline);
+
+	if ((deadline.tv_nsec += YIELDTIME * 1000L) >= 1000000000) {
+		deadline.tv_nsec -= 1000000000;
+		++deadline.tv_sec;
+	}
+
+	while (input_key_pending (q)) {
+		key = eventcount_prepare (&q->passed);
+
+		if (!input_key_pending (q)) {
+			eventcount_cancel (&q->passed);
+			break;
+		}
+
+		if (!eventcount_timedwait (&q->passed, key, &deadline))
+			break;
+	}
+
+	return input_key_pending (q) && count > YIELDSIZE ? YIELDSIZE : count;
+}
+
+/*
+ * Nobody answers terminal queries when output does not go to terminal,
+ * and programs wait for replies until timeout. Reply on behalf of
+ * terminal right away.
+ */
+static void answer_queries (struct relay *o, const char *data, size_t len)
+{
+	buffer_reset (&o->ab);
+
+	if (answer_write (&o->a, data, len, &o->ab) && o->ab.len > 0)
+		safe_write (o->in, o->ab.data, o->ab.len);
+}
+
+/*
+ * Short input chunk with nothing queued ahead is a keystroke, one queued
+ * after paste backlog waits for the backlog anyway
+ */
+static void input_queue (struct relay *o, size_t len)
+{
+	struct input_queue *q = o->queue;
+	size_t queued = atomic_load (&q->queued);
+
+	if (len <= BURSTSIZE && queued == atomic_load (&q->written))
+		atomic_store (&q->key, queued + len);
+
+	atomic_store (&q->queued, queued + len);
+}
+
+static int relay_out (struct relay *o, const void *data, size_t len)
+{
+	/* log failure is reported at end, relay goes on */
+	if (o->log != NULL)
+		logger_write (o->log, data, len);
+
+	if (!o->piped)
+		return safe_write (o->out, data, len) == len;
+
+	if (o->input)
+		input_queue (o, len);
+
+	return ring_put (&o->ring, data, len);
+}
+
+static int stamp_out (struct relay *o, const void *data, size_t len)
+{
+	if (o->clock >= 0) {
+		buffer_reset (&o->sb);
+
+		if (!stamp_write (&o->s, data, len, &o->sb))
+			return 0;
+
+		data = o->sb.data;
+		len  = o->sb.len;
+	}
+
+	return relay_out (o, data, len);
+}
+
+static int utf8_out (struct relay *o, const void *data, size_t len)
+{
+	if (o->utf8) {
+		buffer_reset (&o->ub);
+
+		if (!utf8_write (&o->u, data, len, &o->ub))
+			return 0;
+
+		data = o->ub.data;
+		len  = o->ub.len;
+	}
+
+	return stamp_out (o, data, len);
+}
+
+/*
+ * Output relay passes texts of fired rules to input relay, dropped if
+ * too many are queued already
+ */
+static void relay_send (struct relay *o)
+{
+	struct input_text *t;
+
+	if (o->tb.len == 0)
+		return;
+
+	if ((t = malloc (sizeof (*t) + o->tb.len)) != NULL) {
+		t->len = o->tb.len;
+		memcpy (t->data, o->tb.data, t->len);
+
+		if (spsc_push (&o->queue->texts, t))
+			eventfd_write (o->queue->wake, 1);
+		else
+			free (t);
+	}
+
+	buffer_reset (&o->tb);
+}
+
+/* input relay queues texts of fired rules as user input */
+static void input_take (struct relay *o)
+{
+	struct input_text *t;
+	eventfd_t count;
+
+	eventfd_read (o->queue->wake, &count);
+
+	while ((t = spsc_pop (&o->queue->texts)) != NULL) {
+		relay_out (o, t->data, t->len);
+		free (t);
+	}
+}
+
+/*
+ * Pass chunk through enabled output stages and write it out, returns
+ * zero on failure
+ */
+static int relay_write (struct relay *o, const void *data, size_t len)
+{
+	/* responses go to program, failed one does not stop output */
+	if (o->trigger != NULL) {
+		trigger_write (o->trigger, data, len, &o->tb);
+		relay_send (o);
+	}
+
+	if (o->redact != NULL) {
+		buffer_reset (&o->xb);
+
+		if (!redact_write (o->redact, data, len, &o->xb))
+			return 0;
+
+		data = o->xb.data;
+		len  = o->xb.len;
+	}
+
+	return utf8_out (o, data, len);
+}
+
+/* write out possible secret prefix held back by redaction stage */
+static int redact_idle (struct relay *o)
+{
+	buffer_reset (&o->xb);
+
+	return redact_flush (o->redact, &o->xb) &&
+	       utf8_out (o, o->xb.data, o->xb.len);
+}
+
+/* write out data kept by output stages at end of stream */
+static void relay_flush (struct relay *o)
+{
+	if (o->redact != NULL)
+		redact_idle (o);
+
+	if (o->utf8) {
+		buffer_reset (&o->ub);
+
+		if (utf8_flush (&o->u, &o->ub))
+			stamp_out (o, o->ub.data, o->ub.len);
+	}
+}
+
+/*
+ * While output is idle, possible secret prefix held back by redaction
+ * is written out after a while, and timeout rules fire. Returns ms until
+ * next idle task is due, or -1 if none.
+ */
+static int relay_wait (struct relay *o)
+{
+	long long now = clock_us () / 1000;
+	int wait = -1, t;
+
+	if (o->redact != NULL && o->redact->held > 0)
+		wait = now - o->idle < REDACTTIME ?
+		       o->idle + REDACTTIME - now : 0;
+
+	if (o->trigger != NULL && (t = trigger_wait (o->trigger)) >= 0 &&
+	    (wait < 0 || t < wait))
+		wait = t;
+
+	return wait;
+}
+
+/* run idle tasks that are due */
+static void relay_tick (struct relay *o)
+{
+	if (o->redact != NULL && o->redact->held > 0 &&
+	    clock_us () / 1000 - o->idle >= REDACTTIME)
+		redact_idle (o);
+
+	if (o->trigger != NULL) {
+		trigger_tick (o->trigger, &o->tb);
+		relay_send (o);
+	}
+}
+
+/*
+ * Wait for input running idle tasks and taking texts of fired rules,
+ * returns zero if relay is told to stop reading
+ */
+static int relay_idle (struct relay *o)
+{
+	int wake = o->input ? o->queue->wake : -1, wait, n;
+	struct pollfd p[3] = { { o->in, POLLIN }, { o->stop, POLLIN },
+			       { wake, POLLIN } };
+
+	for (;;) {
+		if ((wait = relay_wait (o)) < 0 && o->stop < 0 && wake < 0)
+			return 1;
+
+		if ((n = poll (p, 3, wait)) > 0 && p[2].revents != 0) {
+			input_take (o);
+			continue;
+		}
+
+		if (n != 0)
+			return (p[1].revents & POLLIN) == 0;
+
+		relay_tick (o);
+	}
+}
+
+/*
+ * In busy-poll mode spin polling input without sleep for a while, then
+ * fall back to blocking read: the spin saves wakeup latency of the
+ * first byte of a burst.
+ */
+static ssize_t relay_read (struct relay *o, void *buf, size_t count)
+{
+	struct pollfd p = { o->in, POLLIN };
+	long long end;
 	ssize_t n;
 
-	while ((n = safe_read (in, buf, sizeof (buf))) > 0 &&
-	       safe_write (out, buf, n) == n) {}
+	count = output_yield (o, count);
+
+	if (!relay_idle (o))
+		return 0;
+
+	if (o->spin > 0)
+		for (end = clock_us () + o->spin;
+		     poll (&p, 1, 0) == 0 && clock_us () < end;) {}
+
+	if ((n = safe_read (o->in, buf, count)) > 0 && o->answer)
+		answer_queries (o, buf, n);
+
+	if (n > 0 && o->rec != NULL)
+		record_write (o->rec, buf, n);
+
+	o->idle = clock_us () / 1000;
+
+	return n;
 }
 
-static void csi_filter (int in, int out)
+static void input_written (struct relay *o, size_t count)
 {
-	enum state { INIT, ESCAPE, CSI } state = INIT;
-	/* reserve one extra byte for delayed ESC symbol in output buffer */
-	char ibuf[BUFSIZE - 1], obuf[BUFSIZE], *end, *p, *q;
+	atomic_fetch_add (&o->queue->written, count);
+	eventcount_notify (&o->queue->passed);
+}
+
+static int input_dropped (struct relay *o)
+{
+	struct input_queue *q = o->queue;
+
+	return (ptrdiff_t) (atomic_load (&q->drop) -
+			    atomic_load (&q->written)) > 0;
+}
+
+/*
+ * Wait until program drains its pty input queue, the queue is seen
+ * from slave side only. Waiting is bounded: program may not read input
+ * at all, then the kernel throttles writes as before.
+ */
+static void pace_wait (struct relay *o)
+{
+	char name[64];
+	int fill;
+	long long end;
+	struct timespec ts = { 0, 250000 };
+
+	if (o->slave < 0 &&
+	    (ptsname_r (o->out, name, sizeof (name)) != 0 ||
+	     (o->slave = open (name, O_RDWR | O_NOCTTY | O_CLOEXEC)) < 0))
+		return;
+
+	for (end = clock_us () + PACETIME;
+	     ioctl (o->slave, FIONREAD, &fill) == 0 && fill > PACEFILL &&
+	     !input_dropped (o) && clock_us () < end;)
+		nanosleep (&ts, NULL);
+}
+
+/*
+ * Slave is kept open only while paste is in progress: it keeps master
+ * from seeing hangup after program exit
+ */
+static void pace_end (struct relay *o)
+{
+	if (o->slave < 0 || o->paste.active || ring_level (&o->ring) > 0)
+		return;
+
+	close (o->slave);
+	o->slave = -1;
+}
+
+/*
+ * If asked to, bracketed paste or a backlog larger than a key sequence
+ * is written in paced chunks, keystrokes go out at once. Pacing is off
+ * by default: kernel throttles writes to master already and pacing
+ * slows slow readers down.
+ */
+static size_t input_pace (struct relay *o, size_t count)
+{
+	if (!o->pace || (count <= BURSTSIZE && !o->paste.active))
+		return count;
+
+	pace_wait (o);
+	return count < PACESIZE ? count : PACESIZE;
+}
+
+/*
+ * Drop input queued before signal character and cancel paste: program
+ * gets interrupt at once and no paste tail after it
+ */
+static int input_drop (struct relay *o)
+{
+	struct input_queue *q = o->queue;
+	size_t count = atomic_load (&q->drop) - atomic_load (&q->written);
+
+	if ((ptrdiff_t) count <= 0)
+		return 0;
+
+	ring_consume (&o->ring, count);
+	input_written (o, count);
+	paste_init (&o->paste);
+	pace_end (o);
+	return 1;
+}
+
+static int writer_proc (void *data)
+{
+	struct relay *o = data;
+	const char *p;
+	size_t n;
+
+	paste_init (&o->paste);
+	o->slave = -1;
+
+	while ((n = ring_peek (&o->ring, &p)) > 0) {
+		n = input_pace (o, output_yield (o, n));
+
+		if (o->input && input_drop (o))
+			continue;
+
+		if (o->input)
+			paste_scan (&o->paste, p, n);
+
+		if (safe_write (o->out, p, n) != n) {
+			ring_shutdown (&o->ring);
+			break;
+		}
+
+		ring_consume (&o->ring, n);
+
+		if (o->input) {
+			input_written (o, n);
+			pace_end (o);
+		}
+	}
+
+	if (o->slave >= 0)
+		close (o->slave);
+
+	return 0;
+}
+
+/*
+ * Move writes into a separate thread, so reading and filtering go on
+ * while output is blocked. Writes stay direct if the thread cannot be
+ * started.
+ */
+static void relay_start (struct relay *o)
+{
+	struct thrd_attr a = { .stack_size = STACKSIZE, .name = "relay-write" };
+
+	o->piped = 0;
+
+	if (!ring_init (&o->ring, RINGSIZE))
+		return;
+
+	if (thrd_create_ex (&o->writer, &a, writer_proc, o) != thrd_success) {
+		ring_fini (&o->ring);
+		return;
+	}
+
+	o->piped = 1;
+}
+
+/* wait until everything passed to writer thread is written out */
+static void relay_stop (struct relay *o)
+{
+	if (!o->piped)
+		return;
+
+	ring_close (&o->ring);
+	thrd_join (o->writer, NULL);
+	ring_fini (&o->ring);
+	o->piped = 0;
+}
+
+static int is_signal (const struct termios *t, int c)
+{
+	return c != _POSIX_VDISABLE &&
+	       (c == t->c_cc[VINTR] || c == t->c_cc[VQUIT] ||
+		c == t->c_cc[VSUSP]);
+}
+
+/*
+ * Signal characters are written to pty at once, ahead of input queued
+ * for writer. Line discipline flushes its input queue on them unless
+ * NOFLSH is set, then input queued for writer is dropped as well: the
+ * rest of a paste must not go to the program after interrupt.
+ */
+static int input_write (struct relay *o, const char *data, size_t len)
+{
+	struct termios t;
+	size_t i, start;
+
+	if (!o->piped || tcgetattr (o->out, &t) != 0 ||
+	    (t.c_lflag & ISIG) == 0)
+		return relay_out (o, data, len);
+
+	for (i = start = 0; i < len; ++i)
+		if (is_signal (&t, (unsigned char) data[i])) {
+			if (!relay_out (o, data + start, i - start))
+				return 0;
+
+			if ((t.c_lflag & NOFLSH) == 0)
+				atomic_store (&o->queue->drop,
+					      atomic_load (&o->queue->queued));
+
+			if (safe_write (o->out, data + i, 1) != 1)
+				return 0;
+
+			start = i + 1;
+		}
+
+	return relay_out (o, data + start, len - start);
+}
+
+static void no_filter (struct relay *o)
+{
+	char buf[BUFSIZE];
 	ssize_t n;
 
-	while ((n = safe_read (in, ibuf, sizeof (ibuf))) > 0) {
-		for (end = ibuf + n, p = ibuf, q = obuf; p < end; ++p)
-			switch (state) {
-			case INIT:
-				if (*p == 033) {
-					state = ESCAPE;
-					break;
-				}
+	while ((n = relay_read (o, buf, sizeof (buf))) > 0 &&
+	       input_write (o, buf, n)) {}
+}
+
+enum csi_state { CSI_INIT, CSI_ESCAPE, CSI_SEQ };
 
-				*q++ = *p;
+struct csi {
+	int state;
+	size_t len;			/* of sequence */
+};
+
+/*
+ * Copy text from p to q dropping CSI sequences, returns end of output.
+ * Output may be one byte longer than input due to delayed ESC symbol.
+ *
+ * Controls inside of sequence are passed as terminal executes them.
+ * Sequence longer than limit or with byte above 0x7f is garbage: it is
+ * dropped and the rest is shown as text, thus broken or endless
+ * sequence cannot hide output.
+ */
+static char *csi_strip (struct csi *o, const char *p, const char *end,
+			char *q)
+{
+	int c;
+
+	for (; p < end; ++p)
+		switch (o->state) {
+		case CSI_INIT:
+			if (*p == 033) {
+				o->state = CSI_ESCAPE;
 				break;
+			}
 
-			case ESCAPE:
-				if (*p == 0133) {
-					state = CSI;
-					break;
-				}
+			*q++ = *p;
+			break;
 
-				*q++ = 033;  /* write delayed ESC symbol */
-				*q++ = *p;
-				state = INIT;
+		case CSI_ESCAPE:
+			if (*p == 0133) {
+				o->state = CSI_SEQ;
+				o->len = 0;
 				break;
+			}
 
-			case CSI:
-				if (*p >= 0100 && *p <= 0176)
-					state = INIT;
+			*q++ = 033;  /* write delayed ESC symbol */
 
+			if (*p == 033)  /* next one may start sequence */
 				break;
+
+			*q++ = *p;
+			o->state = CSI_INIT;
+			break;
+
+		case CSI_SEQ:
+			c = (unsigned char) *p;
+
+			if (c >= 0100 && c <= 0176)
+				o->state = CSI_INIT;
+			else if (c == 033)
+				o->state = CSI_ESCAPE;
+			else if (c == 030 || c == 032)	/* CAN, SUB */
+				o->state = CSI_INIT;
+			else if (c < 040)
+				*q++ = c;
+			else if (c > 0177 || ++o->len > vt_limits.seq) {
+				*q++ = c;
+				o->state = CSI_INIT;
 			}
 
-		n = q - obuf;
+			break;
+		}
+
+	return q;
+}
+
+static void csi_filter (struct relay *o)
+{
+	struct csi state = { CSI_INIT };
+	/* reserve one extra byte for delayed ESC symbol in output buffer */
+	char ibuf[BUFSIZE - 1], obuf[BUFSIZE], *q;
+	ssize_t n;
+
+	while ((n = relay_read (o, ibuf, sizeof (ibuf))) > 0) {
+		q = csi_strip (&state, ibuf, ibuf + n, obuf);
 
-		if (safe_write (out, obuf, n) != n)
+		if (!relay_write (o, obuf, q - obuf))
 			break;
 	}
 }
 
-static int run (char *argv[], pid_t *child)
+static long long clock_ms (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+/*
+ * Keep models of program screen and of receiver screen and send only
+ * differences between them, at most rate frames per second: everything
+ * overwritten between frames is never sent.
+ */
+static void screen_filter (struct relay *o)
 {
-	int master, slave;
-	const char *device;
+	struct screen s, peer;
+	struct buffer b;
+	struct pollfd p[3] = { { o->in, POLLIN }, { o->winch, POLLIN },
+			       { o->stop, POLLIN } };
+	char buf[BUFSIZE];
+	int rows, cols, period = 1000 / o->rate, n, wait;
+	long long now = 0, next = 0;
+	eventfd_t count;
+
+	get_size (&rows, &cols);
 
-	if ((master = posix_openpt (O_RDWR | O_NOCTTY)) < 0)
-		return -1;
+	if (!screen_init (&s, rows, cols))
+		return;
 
-	if (grantpt (master) != 0 || unlockpt (master) != 0 ||
-	    (device = ptsname (master)) == NULL ||
-	    (slave = open (device, O_RDWR)) < 0)
-		goto no_slave;
+	if (!screen_init (&peer, rows, cols))
+		goto no_peer;
 
-	if ((*child = fork ()) < 0)
-		goto no_fork;
+	buffer_init (&b);
 
-	if (*child > 0) {
-		close (slave);
-		return master;
+	for (;;) {
+		if (s.dirty && (now = clock_ms ()) >= next) {
+			buffer_reset (&b);
+
+			if (!screen_update (&s, &peer, &b) ||
+			    !relay_write (o, b.data, b.len))
+				break;
+
+			next = now + period;
+			continue;
+		}
+
+		/* frame or idle task, what comes first */
+		wait = relay_wait (o);
+
+		if (s.dirty && (wait < 0 || next - now < wait))
+			wait = next - now;
+
+		if ((n = poll (p, 3, wait)) < 0) {
+			if (errno == EINTR)
+				continue;
+
+			break;
+		}
+
+		if (n == 0)
+			relay_tick (o);
+
+		if (p[2].revents != 0)
+			break;
+
+		/* receiver contents is unknown after resize, redraw it */
+		if ((p[1].revents & POLLIN) != 0 &&
+		    eventfd_read (o->winch, &count) == 0) {
+			get_size (&rows, &cols);
+
+			if (!screen_resize (&s, rows, cols) ||
+			    !screen_resize (&peer, rows, cols))
+				break;
+
+			peer.dirty = 1;
+		}
+
+		if (p[0].revents == 0)
+			continue;
+
+		if ((n = relay_read (o, buf, sizeof (buf))) <= 0)
+			break;
+
+		screen_write (&s, buf, n);
+	}
+
+	if (s.dirty) {
+		buffer_reset (&b);
+
+		if (screen_update (&s, &peer, &b))
+			relay_write (o, b.data, b.len);
 	}
 
-	close (master);
+	buffer_fini (&b);
+	screen_fini (&peer);
+no_peer:
+	screen_fini (&s);
+}
+
+/*
+ * Convert colored output into attributed text spans, output buffer is
+ * reused for every chunk. Larger chunks are read here to keep per-chunk
+ * overhead low on bulk output.
+ */
+static void span_filter (struct relay *o, int format)
+{
+	struct span_conv s;
+	struct buffer b;
+	char buf[BUFSIZE * 32];
+	ssize_t n;
+
+	span_init (&s, format);
+	buffer_init (&b);
+
+	while ((n = relay_read (o, buf, sizeof (buf))) > 0) {
+		buffer_reset (&b);
 
-	dup2 (slave, 0);
-	dup2 (slave, 1);
-	dup2 (slave, 2);
+		if (!span_write (&s, buf, n, &b) ||
+		    !relay_write (o, b.data, b.len))
+			goto out;
+	}
+
+	buffer_reset (&b);
 
-	if (slave > 2)
-		close (slave);
+	if (span_flush (&s, &b))
+		relay_write (o, b.data, b.len);
+out:
+	buffer_fini (&b);
+	span_fini (&s);
+}
 
-	setsid ();
-	ioctl (0, TIOCSCTTY, 1);
+static void set_size (int master)
+{
+	struct winsize ws = {};
+	int rows, cols;
 
-	execvp (argv[0], argv);
-	perror ("cannot run program");
-	exit (1);
-no_fork:
-	close (slave);
-no_slave:
-	close (master);
+	get_size (&rows, &cols);
+
+	ws.ws_row = rows;
+	ws.ws_col = cols;
+
+	ioctl (master, TIOCSWINSZ, &ws);
+}
+
+/* start program on given pty, returns master or -1 closing pty on error */
+static int run (char *argv[], struct pty *pty, pid_t *child)
+{
+	int e;
+
+	set_size (pty->master);
+
+	/* old C library may know the flag but not support it */
+	if (pty_spawn (pty, argv, child) ||
+	    ((errno == ENOSYS || errno == EINVAL) && pty_fork (pty, argv, child)))
+		return pty->master;
+
+	e = errno;
+	pty_close (pty);
+	errno = e;
 	return -1;
 }
 
 static int no_filter_proc (void *data)
 {
-	int *file = data;
+	struct relay *o = data;
+
+	struct pollfd p = { o->queue->wake, POLLIN };
+
+	relay_start (o);
+	no_filter (o);
+
+	/* user input is over, rules may still send texts */
+	while (p.fd >= 0 && poll (&p, 1, -1) > 0)
+		input_take (o);
+
+	relay_stop (o);
+	return 0;
+}
+
+static int output_proc (void *data)
+{
+	struct relay *o = data;
+	int rows, cols;
 
-	no_filter (file[0], file[1]);
+	utf8_init (&o->u);
+	stamp_init (&o->s, o->clock);
+	buffer_init (&o->ub);
+	buffer_init (&o->sb);
+	buffer_init (&o->xb);
+	buffer_init (&o->ab);
+	buffer_init (&o->tb);
+
+	if (o->answer) {
+		get_size (&rows, &cols);
+		answer_init (&o->a, rows, cols);
+	}
+
+	relay_start (o);
+
+	switch (o->format) {
+	case FORMAT_DIFF:
+		screen_filter (o);
+		break;
+	case FORMAT_JSON:
+		span_filter (o, SPAN_JSON);
+		break;
+	case FORMAT_HTML:
+		span_filter (o, SPAN_HTML);
+		break;
+	default:
+		csi_filter (o);
+	}
+
+	/* end of program output, then end of writes */
+	if (o->done >= 0)
+		eventfd_write (o->done, 1);
+
+	relay_flush (o);
+	relay_stop (o);
+
+	if (o->rec != NULL && !record_fini (o->rec))
+		perror ("cannot write session record");
+
+	if (o->log != NULL && !logger_fini (o->log))
+		perror ("cannot write log");
+
+	if (o->done >= 0)
+		eventfd_write (o->done, 1);
+
+	buffer_fini (&o->tb);
+	buffer_fini (&o->ab);
+	buffer_fini (&o->xb);
+	buffer_fini (&o->sb);
+	buffer_fini (&o->ub);
 	return 0;
 }
 
-static int csi_filter_proc (void *data)
+static void get_signals (sigset_t *set)
+{
+	sigemptyset (set);
+	sigaddset (set, SIGCHLD);
+	sigaddset (set, SIGWINCH);
+	sigaddset (set, SIGTERM);
+	sigaddset (set, SIGHUP);
+	sigaddset (set, SIGINT);
+}
+
+static int pidfd_open (pid_t pid)
+{
+#ifdef SYS_pidfd_open
+	return syscall (SYS_pidfd_open, pid, 0);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+static int reap (pid_t child, int *status)
+{
+	int ret;
+
+	if (waitpid (child, &ret, WNOHANG) != child)
+		return 0;
+
+	*status = WIFEXITED (ret) ? WEXITSTATUS (ret) : 1;
+	return 1;
+}
+
+/*
+ * Wait for program exit handling signals and return its status.
+ * Signals are blocked in all threads and arrive through signalfd; exit
+ * is seen through pidfd or, on older kernels, SIGCHLD.
+ *
+ * Window drags send a storm of SIGWINCH and every resize makes full
+ * screen programs redraw, so resizes are coalesced: the last size is
+ * passed on after quiet ms without resizes, or after hold ms since the
+ * first pending one while the drag continues. Applied resize is signaled
+ * to winch eventfd if any.
+ */
+static int supervise (pid_t child, int master, int winch, int quiet,
+		      int hold)
+{
+	enum { SIGNALS, CHILD, COUNT };
+	struct pollfd p[COUNT] = {};
+	struct signalfd_siginfo si;
+	sigset_t set;
+	int status = 1, timeout;
+	long long now, first = -1, last = 0;  /* pending resize times */
+
+	get_signals (&set);
+
+	p[SIGNALS].fd = signalfd (-1, &set, SFD_CLOEXEC);
+	p[CHILD].fd   = pidfd_open (child);
+
+	p[SIGNALS].events = p[CHILD].events = POLLIN;
+
+	if (p[SIGNALS].fd < 0) {
+		perror ("cannot watch signals");
+		goto wait;
+	}
+
+	/* SIGCHLD may be lost before it was blocked */
+	while (!reap (child, &status)) {
+		timeout = -1;
+
+		if (first >= 0) {
+			now = clock_ms ();
+
+			if (now - last >= quiet || now - first >= hold) {
+				set_size (master);
+				first = -1;
+
+				if (winch >= 0)
+					eventfd_write (winch, 1);
+			}
+			else
+				timeout = last + quiet < first + hold ?
+					  last + quiet - now :
+					  first + hold - now;
+		}
+
+		if (poll (p, COUNT, timeout) < 0) {
+			if (errno == EINTR)
+				continue;
+
+			perror ("cannot wait for program");
+			goto wait;
+		}
+
+		if ((p[SIGNALS].revents & POLLIN) == 0 ||
+		    read (p[SIGNALS].fd, &si, sizeof (si)) != sizeof (si))
+			continue;
+
+		switch (si.ssi_signo) {
+		case SIGCHLD:
+			break;
+		case SIGWINCH:
+			last = clock_ms ();
+
+			if (first < 0)
+				first = last;
+			break;
+		default:
+			kill (child, si.ssi_signo);
+		}
+	}
+
+	close (p[SIGNALS].fd);
+
+	if (p[CHILD].fd >= 0)
+		close (p[CHILD].fd);
+
+	return status;
+wait:
+	if (p[SIGNALS].fd >= 0)
+		close (p[SIGNALS].fd);
+
+	if (p[CHILD].fd >= 0)
+		close (p[CHILD].fd);
+
+	if (waitpid (child, &status, 0) != child)
+		perror ("cannot get program status");
+	else
+		status = WIFEXITED (status) ? WEXITSTATUS (status) : 1;
+
+	return status;
+}
+
+/*
+ * Program output may be held open by its children, thus wait for its
+ * end a bit only, then tell output relay to stop reading. Writes queued
+ * before are always waited for: relay flushes them, closes record and
+ * log, and signals done once more.
+ */
+static void drain (int done, int stop)
+{
+	struct pollfd p = { done, POLLIN };
+	int timeout, n, ends = 0;
+	eventfd_t count;
+
+	for (timeout = DRAINTIME; ends < 2; timeout = -1) {
+		if ((n = poll (&p, 1, timeout)) < 0 && errno == EINTR)
+			continue;
+
+		if (n == 0) {
+			eventfd_write (stop, 1);
+			continue;
+		}
+
+		if (n < 0 || eventfd_read (done, &count) != 0) {
+			eventfd_write (stop, 1);
+			break;
+		}
+
+		ends += count;
+	}
+}
+
+/*
+ * Runner mode: run commands read line by line, up to a number of jobs
+ * at once, each one on its own pty. Single thread polls all masters,
+ * strips CSI sequences and writes complete output lines prefixed with
+ * job number, so lines of different jobs never mix.
+ *
+ * Programs are started by pool workers, thus a slow start does not hold
+ * output of running jobs. Worker hands started job back through a queue
+ * and wakes the runner.
+ */
+struct job {
+	struct pool_task task;		/* first: job is found by task */
+	struct runner *runner;
+	int id, master;
+	pid_t pid;			/* zero when reaped */
+	int starting;			/* owned by worker */
+	int error;			/* of start */
+	struct pty pty;
+	struct csi state;		/* CSI strip state */
+	char *cmd;
+	struct buffer line;
+};
+
+struct runner {
+	struct job *job;
+	int count;			/* job slots */
+	int started, failed, stop;	/* stop is signal to pass */
+	FILE *in;
+	struct pool workers;
+	struct mpsc_queue ready;	/* of started jobs */
+	int wake;			/* eventfd signaled on start */
+	struct buffer out;
+};
+
+static void job_line (struct runner *o, struct job *j)
+{
+	buffer_addc (&o->out, '[');
+	buffer_addu (&o->out, j->id);
+	buffer_adds (&o->out, "] ");
+	buffer_add  (&o->out, j->line.data, j->line.len);
+	buffer_addc (&o->out, '\n');
+
+	buffer_reset (&j->line);
+}
+
+static void job_text (struct runner *o, struct job *j, const char *p,
+		      const char *end)
+{
+	for (; p < end; ++p)
+		switch (*p) {
+		case '\r':
+			break;
+		case '\n':
+			job_line (o, j);
+			break;
+		default:
+			buffer_addc (&j->line, *p);
+
+			if (j->line.len >= LINESIZE)
+				job_line (o, j);
+		}
+}
+
+/* returns zero at end of output */
+static int job_read (struct runner *o, struct job *j)
 {
-	int *file = data;
+	char ibuf[BUFSIZE - 1], obuf[BUFSIZE], *q;
+	ssize_t n;
+
+	if ((n = safe_read (j->master, ibuf, sizeof (ibuf))) > 0) {
+		q = csi_strip (&j->state, ibuf, ibuf + n, obuf);
+		job_text (o, j, obuf, q);
+		return 1;
+	}
+
+	/* slave closed (EIO) or nothing left after program exit */
+	if (n < 0 && errno == EAGAIN)
+		return 0;
 
-	csi_filter (file[0], file[1]);
+	if (j->line.len > 0)
+		job_line (o, j);
+
+	close (j->master);
+	j->master = -1;
 	return 0;
 }
 
+/* pool task: start program and hand job back to runner */
+static void job_spawn (struct pool_task *t)
+{
+	struct job *j = (void *) t;
+	char *argv[] = { "sh", "-c", j->cmd, NULL };
+
+	if ((j->master = run (argv, &j->pty, &j->pid)) < 0) {
+		j->error = errno;
+		j->pid = 0;
+	}
+
+	/* queue has a cell for every job */
+	mpsc_push (&j->runner->ready, j);
+	eventfd_write (j->runner->wake, 1);
+}
+
+static int runner_start (struct runner *o, struct job *j)
+{
+	size_t size = 0;
+	ssize_t len;
+
+	j->cmd = NULL;
+
+	while ((len = getline (&j->cmd, &size, o->in)) > 0) {
+		if (j->cmd[len - 1] == '\n')
+			j->cmd[len - 1] = '\0';
+
+		if (j->cmd[0] != '\0')
+			break;
+	}
+
+	if (len <= 0) {
+		free (j->cmd);
+		return 0;
+	}
+
+	j->id = ++o->started;
+	j->state.state = CSI_INIT;
+
+	if (!pty_open (&j->pty)) {
+		fprintf (stderr, "term-filter: job %d: cannot run %s: %s\n",
+			 j->id, j->cmd, strerror (errno));
+		++o->failed;
+		free (j->cmd);
+		return 1;
+	}
+
+	j->task.fn = job_spawn;
+	j->starting = 1;
+	pool_submit (&o->workers, &j->task, NULL);
+	return 1;
+}
+
+/*
+ * Only jobs known to be started are waited for: a job exited before
+ * runner got it from worker is reaped when it is got
+ */
+static void runner_reap (struct runner *o)
+{
+	int i, status;
+	struct job *j;
+
+	for (i = 0, j = o->job; i < o->count; ++i, ++j) {
+		if (j->starting || j->pid == 0 ||
+		    waitpid (j->pid, &status, WNOHANG) != j->pid)
+			continue;
+
+		/* output of exited program is in pty already */
+		if (j->master >= 0) {
+			fcntl (j->master, F_SETFL, O_NONBLOCK);
+
+			while (job_read (o, j)) {}
+
+			if (j->master >= 0) {
+				close (j->master);
+				j->master = -1;
+			}
+		}
+
+		if (!WIFEXITED (status) || WEXITSTATUS (status) != 0) {
+			fprintf (stderr, "term-filter: job %d failed with "
+				 "status %d: %s\n", j->id,
+				 WIFEXITED (status) ? WEXITSTATUS (status) :
+				 128 + WTERMSIG (status), j->cmd);
+			++o->failed;
+		}
+
+		j->pid = 0;
+		free (j->cmd);
+	}
+}
+
+static void runner_ready (struct runner *o)
+{
+	struct job *j;
+	eventfd_t count;
+
+	eventfd_read (o->wake, &count);
+
+	while ((j = mpsc_pop (&o->ready)) != NULL) {
+		j->starting = 0;
+
+		if (j->master < 0) {
+			fprintf (stderr, "term-filter: job %d: cannot run "
+				 "%s: %s\n", j->id, j->cmd,
+				 strerror (j->error));
+			++o->failed;
+			free (j->cmd);
+		}
+		else if (o->stop)
+			kill (j->pid, o->stop);
+	}
+
+	runner_reap (o);
+}
+
+static void runner_signal (struct runner *o, int sfd)
+{
+	struct signalfd_siginfo si;
+	int i;
+
+	if (read (sfd, &si, sizeof (si)) != sizeof (si))
+		return;
+
+	switch (si.ssi_signo) {
+	case SIGCHLD:
+		runner_reap (o);
+		break;
+	case SIGWINCH:
+		for (i = 0; i < o->count; ++i)
+			if (o->job[i].master >= 0)
+				set_size (o->job[i].master);
+		break;
+	default:
+		o->stop = si.ssi_signo;
+
+		for (i = 0; i < o->count; ++i)
+			if (!o->job[i].starting && o->job[i].pid > 0)
+				kill (o->job[i].pid, si.ssi_signo);
+	}
+}
+
+/* returns zero if all commands are run and succeeded */
+static int runner (FILE *in, int count)
+{
+	enum { SIGNALS, READY, JOBS };
+	struct runner o = { .count = count, .in = in };
+	struct pollfd *p;
+	sigset_t set;
+	size_t size;
+	int i, active, status = 1;
+
+	get_signals (&set);
+
+	for (size = 1; size < (size_t) count; size *= 2) {}
+
+	o.job = calloc (count, sizeof (o.job[0]));
+	p = calloc (count + JOBS, sizeof (p[0]));
+
+	if (o.job == NULL || p == NULL) {
+		perror ("cannot start jobs");
+		goto no_workers;
+	}
+
+	if (!pool_init (&o.workers, 0)) {
+		perror ("cannot start jobs");
+		goto no_workers;
+	}
+
+	if (!mpsc_init (&o.ready, size)) {
+		perror ("cannot start jobs");
+		goto no_ready;
+	}
+
+	if ((o.wake = eventfd (0, EFD_CLOEXEC)) < 0) {
+		perror ("cannot start jobs");
+		goto no_wake;
+	}
+
+	if ((p[SIGNALS].fd = signalfd (-1, &set, SFD_CLOEXEC)) < 0) {
+		perror ("cannot watch signals");
+		goto no_signals;
+	}
+
+	p[SIGNALS].events = POLLIN;
+	p[READY].fd = o.wake;
+	p[READY].events = POLLIN;
+	buffer_init (&o.out);
+
+	for (i = 0; i < count; ++i) {
+		o.job[i].runner = &o;
+		o.job[i].master = -1;
+		buffer_init (&o.job[i].line);
+	}
+
+	for (;;) {
+		for (active = 0, i = 0; i < count; ++i) {
+			struct job *j = o.job + i;
+
+			while (!j->starting && j->master < 0 && j->pid == 0 &&
+			       !o.stop && !feof (o.in) && runner_start (&o, j)) {}
+
+			if (j->starting || j->master >= 0 || j->pid > 0)
+				++active;
+
+			/* negative fd is skipped by poll */
+			p[JOBS + i].fd = j->starting ? -1 : j->master;
+			p[JOBS + i].events = POLLIN;
+		}
+
+		if (active == 0)
+			break;
+
+		if (poll (p, count + JOBS, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+
+			perror ("cannot wait for jobs");
+			break;
+		}
+
+		for (i = 0; i < count; ++i)
+			if (p[JOBS + i].revents != 0)
+				job_read (&o, o.job + i);
+
+		if (p[READY].revents & POLLIN)
+			runner_ready (&o);
+
+		if (p[SIGNALS].revents & POLLIN)
+			runner_signal (&o, p[SIGNALS].fd);
+
+		if (o.out.len > 0) {
+			safe_write (1, o.out.data, o.out.len);
+			buffer_reset (&o.out);
+		}
+	}
+
+	if (o.failed > 0)
+		fprintf (stderr, "term-filter: %d of %d jobs failed\n",
+			 o.failed, o.started);
+
+	status = o.failed > 0 || o.stop || ferror (o.in);
+
+	for (i = 0; i < count; ++i)
+		buffer_fini (&o.job[i].line);
+
+	buffer_fini (&o.out);
+	close (p[SIGNALS].fd);
+no_signals:
+	close (o.wake);
+no_wake:
+	mpsc_fini (&o.ready);
+no_ready:
+	pool_fini (&o.workers);
+no_workers:
+	free (p);
+	free (o.job);
+	return status;
+}
+
+static int get_log_flags (const char *s)
+{
+	int flags = 0;
+	size_t len;
+
+	for (; *s != '\0'; s += len + (s[len] == ',')) {
+		len = strcspn (s, ",");
+
+		if (len == 5 && strncmp (s, "block", len) == 0)
+			flags &= ~LOG_DROP;
+		else if (len == 4 && strncmp (s, "drop", len) == 0)
+			flags |= LOG_DROP;
+		else if (len == 6 && strncmp (s, "direct", len) == 0)
+			flags |= LOG_DIRECT;
+		else if (len == 2 && strncmp (s, "lz", len) == 0)
+			flags |= LOG_COMPRESS;
+		else
+			return -1;
+	}
+
+	return flags;
+}
+
+static int get_limits (const char *s, struct vt_limits *o)
+{
+	char *end;
+
+	o->seq = strtol (s, &end, 10);
+
+	if (*end == ',')
+		o->string = strtol (end + 1, &end, 10);
+
+	if (*end == ',')
+		o->params = strtol (end + 1, &end, 10);
+
+	return *end == '\0' && o->seq > 0 && o->seq <= 65536 &&
+	       o->string > 0 && o->string <= (1 << 24) &&
+	       o->params > 0 && o->params <= VT_MAX_PARAMS;
+}
+
+static const char *usage =
+	"usage:\n"
+	"\tterm-filter [options] program [args...]\n"
+	"\tterm-filter -j jobs [file]\n"
+	"\n"
+	"options:\n"
+	"\t-a cpus    pin relay threads to CPU list like 0,2-3\n"
+	"\t-A         do not answer terminal queries when output is not\n"
+	"\t           a terminal\n"
+	"\t-b usec    busy-poll input for given time before blocking read\n"
+	"\t-e file    answer output matching rules from file, see trigger.h\n"
+	"\t-f format  output format: text (default), diff, json or html\n"
+	"\t-j jobs    run commands from file or stdin, up to jobs at once,\n"
+	"\t           prefix output lines with job number (no -a, -n, -p)\n"
+	"\t-l file    write copy of output to file from separate thread\n"
+	"\t-L flags   log flags: block (wait on full queue, default) or drop,\n"
+	"\t           direct (bypass page cache), lz (compress, read it\n"
+	"\t           with term-zcat)\n"
+	"\t-m len[,len[,count]]\n"
+	"\t           max escape sequence length, string (OSC, DCS) length\n"
+	"\t           and parameter count, longer garbage is shown as text\n"
+	"\t           (default 256,65536,16)\n"
+	"\t-n nice    run relay threads with given nice level\n"
+	"\t-p prio    run relay threads with SCHED_FIFO priority\n"
+	"\t-P         pace pasted input by program reading, for programs\n"
+	"\t           that lose canonical lines longer than 4 KiB\n"
+	"\t-r rate    maximum screen updates per second for diff format\n"
+	"\t-s file    record session to file seekable with term-replay\n"
+	"\t-t clock   prefix output lines with time: wall or elapsed\n"
+	"\t-u         replace invalid UTF-8 in output, never split characters\n"
+	"\t-w ms[,ms] pass resize after quiet time, hold it no longer than\n"
+	"\t           second time (default 50,200; 0 passes every resize)\n"
+	"\t-x file    mask output matching patterns from file, one per line\n";
+
 int main (int argc, char *argv[])
 {
 	pid_t child;
-	int master, status = 1;
+	int c, master, status = 1, rows, cols;
+	int quiet = WINCHQUIET, hold = WINCHQUIET * WINCHHOLD, jobs = 0;
+	const char *record = NULL, *log_path = NULL, *patterns = NULL;
+	const char *rules = NULL;
+	int log_flags = 0, tuned = 0, noanswer = 0;
+	unsigned long dropped;
+	FILE *in;
+	char *end;
 
 	struct termios to, tn;
+	sigset_t set;
 
-	int f1[2], f2[2];
+	/* detached input relay thread may outlive main */
+	static struct input_queue queue;
+	static struct relay f1 = { .input = 1, .queue = &queue, .done = -1,
+				   .winch = -1, .stop = -1 },
+			    f2 = { .rate = 50, .clock = -1, .queue = &queue };
+	struct pty pty;
+	static struct recorder rec;
+	static struct logger log;
+	static struct redact redact;
+	static struct trigger trigger;
+	struct tune tune;
+	struct thrd_attr a1 = { .stack_size = STACKSIZE, .name = "relay-in" };
+	struct thrd_attr a2 = { .stack_size = STACKSIZE, .name = "relay-out" };
 	thrd_t t1, t2;
 
-	if (argc < 2) {
-		fprintf (stderr, "usage:\n\tterm-filter program [args...]\n");
+	tune_init (&tune);
+
+	while ((c = getopt (argc, argv, "+a:Ab:e:f:j:l:L:m:n:p:Pr:s:t:uw:x:")) != -1)
+		switch (c) {
+		case 'a':
+			if (!tune_cpus (&tune, optarg))
+				goto usage;
+
+			tuned = 1;
+			break;
+		case 'A':
+			noanswer = 1;
+			break;
+		case 'b':
+			if ((f1.spin = atoi (optarg)) <= 0 || f1.spin > 1000000)
+				goto usage;
+
+			f2.spin = f1.spin;
+			break;
+		case 'e':
+			rules = optarg;
+			break;
+		case 'f':
+			if (strcmp (optarg, "text") == 0)
+				f2.format = FORMAT_TEXT;
+			else if (strcmp (optarg, "diff") == 0)
+				f2.format = FORMAT_DIFF;
+			else if (strcmp (optarg, "json") == 0)
+				f2.format = FORMAT_JSON;
+			else if (strcmp (optarg, "html") == 0)
+				f2.format = FORMAT_HTML;
+			else
+				goto usage;
+			break;
+		case 'j':
+			if ((jobs = atoi (optarg)) <= 0 || jobs > 1024)
+				goto usage;
+			break;
+		case 'l':
+			log_path = optarg;
+			break;
+		case 'L':
+			if ((log_flags = get_log_flags (optarg)) < 0)
+				goto usage;
+			break;
+		case 'm':
+			if (!get_limits (optarg, &vt_limits))
+				goto usage;
+			break;
+		case 'n':
+			if ((tune.nice = atoi (optarg)) < -20 || tune.nice > 19)
+				goto usage;
+
+			tuned = 1;
+			break;
+		case 'p':
+			if ((tune.fifo = atoi (optarg)) < 1 || tune.fifo > 99)
+				goto usage;
+
+			tuned = 1;
+			break;
+		case 'r':
+			if ((f2.rate = atoi (optarg)) <= 0 || f2.rate > 1000)
+				goto usage;
+			break;
+		case 's':
+			record = optarg;
+			break;
+		case 't':
+			if (strcmp (optarg, "wall") == 0)
+				f2.clock = STAMP_WALL;
+			else if (strcmp (optarg, "elapsed") == 0)
+				f2.clock = STAMP_ELAPSED;
+			else
+				goto usage;
+			break;
+		case 'P':
+			f1.pace = 1;
+			break;
+		case 'u':
+			f2.utf8 = 1;
+			break;
+		case 'w':
+			quiet = strtol (optarg, &end, 10);
+			hold  = *end == ',' ? strtol (end + 1, &end, 10) :
+					      quiet * WINCHHOLD;
+
+			if (*end != '\0' || quiet < 0 || hold < quiet ||
+			    hold > 10000)
+				goto usage;
+			break;
+		case 'x':
+			patterns = optarg;
+			break;
+		default:
+			goto usage;
+		}
+
+	/* session record keeps raw output */
+	if (patterns != NULL && record != NULL) {
+		fputs ("term-filter: cannot record session with redaction\n",
+		       stderr);
 		return 1;
 	}
 
-	if ((master = run (argv + 1, &child)) < 0) {
+	if (jobs > 0) {
+		if (optind + 1 < argc)
+			goto usage;
+
+		/* runner relays in the thread that starts jobs, they inherit */
+		if (tuned) {
+			fputs ("term-filter: cannot tune relay threads of runner\n",
+			       stderr);
+			return 1;
+		}
+
+		if (optind == argc)
+			in = stdin;
+		else if ((in = fopen (argv[optind], "re")) == NULL) {
+			perror (argv[optind]);
+			return 1;
+		}
+
+		/* signals go to runner through signalfd */
+		get_signals (&set);
+		sigprocmask (SIG_BLOCK, &set, NULL);
+
+		return runner (in, jobs);
+	}
+
+	if (optind == argc)
+		goto usage;
+
+	if (record != NULL) {
+		get_size (&rows, &cols);
+
+		if (!record_init (&rec, record, rows, cols)) {
+			perror (record);
+			return 1;
+		}
+
+		f2.rec = &rec;
+	}
+
+	if (log_path != NULL) {
+		if (!logger_init (&log, log_path, log_flags)) {
+			perror (log_path);
+			return 1;
+		}
+
+		f2.log = &log;
+	}
+
+	if (patterns != NULL) {
+		if (redact_init (&redact, patterns))
+			f2.redact = &redact;
+		else if (errno == EINVAL)
+			fprintf (stderr, "term-filter: %s:%d: wrong pattern\n",
+				 patterns, redact.line);
+		else
+			perror (patterns);
+
+		if (f2.redact == NULL)
+			return 1;
+	}
+
+	if (rules != NULL) {
+		if (trigger_init (&trigger, rules))
+			f2.trigger = &trigger;
+		else if (errno == EINVAL)
+			fprintf (stderr, "term-filter: %s:%d: wrong rule\n",
+				 rules, trigger.line);
+		else
+			perror (rules);
+
+		if (f2.trigger == NULL)
+			return 1;
+	}
+
+	if (!input_queue_init (&queue, f2.trigger != NULL)) {
+		perror ("term-filter");
+		return 1;
+	}
+
+	if (!pty_open (&pty) ||
+	    (master = run (argv + optind, &pty, &child)) < 0) {
 		perror ("cannot run program");
 		return 1;
 	}
 
+	/* program is started already, relay threads will inherit settings */
+	if (!tune_apply (&tune))
+		perror ("cannot set relay thread scheduling");
+
 	if (isatty (0)) {
 		tcgetattr (0, &to);
 		tn = to;
@@ -176,26 +1818,49 @@ int main (int argc, char *argv[])
 		tcsetattr (0, TCSANOW, &tn);
 	}
 
-	f1[0] = 0;
-	f1[1] = master;
-	f2[0] = master;
-	f2[1] = 1;
+	f1.in  = 0;
+	f1.out = master;
+	f2.in  = master;
+	f2.out = 1;
+	f2.answer = !noanswer && !isatty (1);
+	f2.done = eventfd (0, EFD_CLOEXEC);
+	f2.stop = eventfd (0, EFD_CLOEXEC);
+	f2.winch = f2.format == FORMAT_DIFF ? eventfd (0, EFD_CLOEXEC) : -1;
 
-	thrd_create (&t1, no_filter_proc,  f1);
-	thrd_create (&t2, csi_filter_proc, f2);
+	/* relay threads inherit mask, signals go to supervisor only */
+	get_signals (&set);
+	sigprocmask (SIG_BLOCK, &set, NULL);
+
+	thrd_create_ex (&t1, &a1, no_filter_proc, &f1);
+	thrd_create_ex (&t2, &a2, output_proc,    &f2);
 
 	thrd_detach (t1);
-	thrd_detach (t2);
 
-	sleep (1);  /* wait a bit for error messages from child if any */
+	status = supervise (child, master, f2.winch, quiet, hold);
 
-	if (waitpid (child, &status, 0) != child)
-		perror ("cannot get program status");
+	/* output relay is stopped and joined, log and record are complete */
+	if (f2.done >= 0 && f2.stop >= 0) {
+		drain (f2.done, f2.stop);
+		thrd_join (t2, NULL);
+	}
 	else
-		status = WIFEXITED (status) ? WEXITSTATUS (status) : 1;
+		thrd_detach (t2);
 
 	if (isatty (0))
 		tcsetattr (0, TCSANOW, &to);
 
+	if (f2.log != NULL && (dropped = atomic_load (&log.dropped)) > 0)
+		fprintf (stderr, "term-filter: dropped %lu bytes of log\n",
+			 dropped);
+
+	if (f2.log != NULL && log.out_bytes > 0)
+		fprintf (stderr, "term-filter: log compressed %llu to %llu "
+			 "bytes (%.1fx) at %.0f MB/s\n", log.in_bytes,
+			 log.out_bytes, (double) log.in_bytes / log.out_bytes,
+			 log.in_bytes / 1e6 / (log.ztime > 0 ? log.ztime : 1e-9));
+
 	return status;
+usage:
+	fputs (usage, stderr);
+	return 1;
 }
@@ -0,0 +1,416 @@
+/*
+ * Terminal Filter Load Generator
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "pty.h"
+
+#define BURSTMAX  4096		/* pty input queue size */
+#define SETTLE    200000	/* wait for sessions to start, us */
+
+/* echo every byte back as soon as it is read */
+#define ECHOPROG  "stty raw -echo; exec cat"
+
+struct samples {
+	long *data;
+	size_t len, size;
+};
+
+static int samples_add (struct samples *o, long x)
+{
+	long *p;
+
+	if (o->len == o->size) {
+		if ((p = realloc (o->data, (o->size * 2 + 64) * sizeof (*p))) == NULL)
+			return 0;
+
+		o->data = p;
+		o->size = o->size * 2 + 64;
+	}
+
+	o->data[o->len++] = x;
+	return 1;
+}
+
+static int cmp_long (const void *a, const void *b)
+{
+	long x = *(const long *) a, y = *(const long *) b;
+
+	return (x > y) - (x < y);
+}
+
+/* sorts samples, q in per mille */
+static long samples_q (struct samples *o, int q)
+{
+	if (o->len == 0)
+		return 0;
+
+	qsort (o->data, o->len, sizeof (o->data[0]), cmp_long);
+	return o->data[(o->len - 1) * q / 1000];
+}
+
+static long long clock_us (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+struct session {
+	struct pty pty;
+	pid_t pid;
+	long long sent, next;		/* send times, us */
+	int want;			/* bytes to be echoed */
+	int keys;
+};
+
+struct load {
+	char **argv;			/* term-filter command */
+	int interval;			/* keystroke period, us */
+	int burst, every;		/* burst size and period in keys */
+	int duration;			/* measurement time, s */
+	struct samples key, paste;
+};
+
+/*
+ * Start term-filter on raw slave side of its own pty, as a user
+ * terminal would run it
+ */
+static int session_start (struct load *o, struct session *s)
+{
+	posix_spawn_file_actions_t fa;
+	posix_spawnattr_t sa;
+	struct termios t;
+	int slave, ret;
+
+	if (!pty_open (&s->pty))
+		return 0;
+
+	if ((slave = open (s->pty.name, O_RDWR | O_NOCTTY)) < 0)
+		goto no_slave;
+
+	tcgetattr (slave, &t);
+	cfmakeraw (&t);
+	tcsetattr (slave, TCSANOW, &t);
+
+	posix_spawn_file_actions_init (&fa);
+	posix_spawn_file_actions_addopen (&fa, 0, s->pty.name, O_RDWR, 0);
+	posix_spawn_file_actions_adddup2 (&fa, 0, 1);
+	posix_spawn_file_actions_adddup2 (&fa, 0, 2);
+	posix_spawnattr_init (&sa);
+	posix_spawnattr_setflags (&sa, POSIX_SPAWN_SETSID);
+
+	ret = posix_spawnp (&s->pid, o->argv[0], &fa, &sa, o->argv, environ);
+
+	posix_spawnattr_destroy (&sa);
+	posix_spawn_file_actions_destroy (&fa);
+	close (slave);
+
+	if ((errno = ret) != 0)
+		goto no_slave;
+
+	fcntl (s->pty.master, F_SETFL, O_NONBLOCK);
+	s->want = s->keys = 0;
+	return 1;
+no_slave:
+	pty_close (&s->pty);
+	return 0;
+}
+
+static void session_send (struct load *o, struct session *s, long long now)
+{
+	static char burst[BURSTMAX];
+	int len = 1;
+	ssize_t n;
+
+	if (o->every > 0 && s->keys % o->every == o->every - 1) {
+		memset (burst, 'p', o->burst);
+		len = o->burst;
+	}
+	else
+		burst[0] = 'k';
+
+	if ((n = write (s->pty.master, burst, len)) <= 0) {
+		s->next = now + o->interval;
+		return;
+	}
+
+	s->sent = now;
+	s->want = n;
+	++s->keys;
+}
+
+static void session_read (struct load *o, struct session *s, long long now)
+{
+	char buf[BURSTMAX];
+	ssize_t n;
+	int paste = s->want > 1;
+
+	if ((n = read (s->pty.master, buf, sizeof (buf))) <= 0 || s->want == 0)
+		return;
+
+	if ((s->want -= n) > 0)
+		return;
+
+	samples_add (paste ? &o->paste : &o->key, now - s->sent);
+	s->want = 0;
+	s->next = now + o->interval;
+}
+
+struct usage {
+	double cpu;			/* user and system time, s */
+	long rss, threads, switches;
+};
+
+static void proc_usage (pid_t pid, struct usage *u)
+{
+	char path[64], line[256];
+	struct timespec ts;
+	clockid_t clock;
+	struct dirent *de;
+	long x;
+	FILE *f;
+	DIR *d;
+
+	/* ticks of /proc/pid/stat are too coarse for idle sessions */
+	if (clock_getcpuclockid (pid, &clock) == 0 &&
+	    clock_gettime (clock, &ts) == 0)
+		u->cpu += ts.tv_sec + ts.tv_nsec / 1e9;
+
+	snprintf (path, sizeof (path), "/proc/%d/status", (int) pid);
+
+	if ((f = fopen (path, "r")) != NULL) {
+		while (fgets (line, sizeof (line), f) != NULL)
+			if (sscanf (line, "VmRSS: %ld", &x) == 1)
+				u->rss += x;
+			else if (sscanf (line, "Threads: %ld", &x) == 1)
+				u->threads += x;
+
+		fclose (f);
+	}
+
+	snprintf (path, sizeof (path), "/proc/%d/task", (int) pid);
+
+	if ((d = opendir (path)) == NULL)
+		return;
+
+	/* switches are counted per thread */
+	while ((de = readdir (d)) != NULL) {
+		if (de->d_name[0] == '.')
+			continue;
+
+		if (snprintf (path, sizeof (path), "/proc/%d/task/%s/status",
+			      (int) pid, de->d_name) >= (int) sizeof (path) ||
+		    (f = fopen (path, "r")) == NULL)
+			continue;
+
+		while (fgets (line, sizeof (line), f) != NULL)
+			if (sscanf (line, "voluntary_ctxt_switches: %ld", &x) == 1 ||
+			    sscanf (line, "nonvoluntary_ctxt_switches: %ld", &x) == 1)
+				u->switches += x;
+
+		fclose (f);
+	}
+
+	closedir (d);
+}
+
+/* run count sessions and print CSV row, returns number of sessions run */
+static int load_run (struct load *o, int count)
+{
+	struct session *s = calloc (count, sizeof (s[0]));
+	struct pollfd *p = calloc (count, sizeof (p[0]));
+	struct usage u = {};
+	long long now, start, end;
+	int i, n = 0, timeout;
+
+	if (s == NULL || p == NULL)
+		goto no_sessions;
+
+	for (n = 0; n < count && session_start (o, s + n); ++n) {}
+
+	if (n < count)
+		fprintf (stderr, "term-load: started %d of %d sessions: %s\n",
+			 n, count, strerror (errno));
+
+	start = clock_us () + SETTLE;
+	end = start + o->duration * 1000000LL;
+
+	/* spread keystrokes of sessions over the period */
+	for (i = 0; i < n; ++i) {
+		s[i].next = start + (long long) o->interval * i / n;
+		p[i].fd = s[i].pty.master;
+		p[i].events = POLLIN;
+	}
+
+	o->key.len = o->paste.len = 0;
+
+	while ((now = clock_us ()) < end) {
+		long long next = end;
+
+		for (i = 0; i < n; ++i) {
+			if (s[i].want == 0 && s[i].next <= now)
+				session_send (o, s + i, now);
+
+			if (s[i].want == 0 && s[i].next < next)
+				next = s[i].next;
+		}
+
+		timeout = next > now ? (next - now + 999) / 1000 : 0;
+
+		if (poll (p, n, timeout) < 0 && errno != EINTR)
+			break;
+
+		now = clock_us ();
+
+		for (i = 0; i < n; ++i)
+			if (p[i].revents & POLLIN)
+				session_read (o, s + i, now);
+	}
+
+	for (i = 0; i < n; ++i)
+		proc_usage (s[i].pid, &u);
+
+	printf ("%d,%zu,%ld,%ld,%ld,%zu,%ld,%ld,%.3f,%ld,%ld,%ld\n", n,
+		o->key.len, samples_q (&o->key, 500), samples_q (&o->key, 990),
+		samples_q (&o->key, 1000), o->paste.len,
+		samples_q (&o->paste, 500), samples_q (&o->paste, 990),
+		u.cpu, u.rss, u.threads, u.switches);
+	fflush (stdout);
+
+	for (i = 0; i < n; ++i)
+		kill (s[i].pid, SIGTERM);
+
+	for (i = 0; i < n; ++i) {
+		waitpid (s[i].pid, NULL, 0);
+		pty_close (&s[i].pty);
+	}
+no_sessions:
+	free (p);
+	free (s);
+	return n;
+}
+
+static void raise_fd_limit (void)
+{
+	struct rlimit r;
+
+	if (getrlimit (RLIMIT_NOFILE, &r) == 0) {
+		r.rlim_cur = r.rlim_max;
+		setrlimit (RLIMIT_NOFILE, &r);
+	}
+}
+
+static const char *usage =
+	"usage:\n"
+	"\tterm-load [options] [term-filter [options]]\n"
+	"\n"
+	"options:\n"
+	"\t-b bytes   paste burst size, default 512\n"
+	"\t-d sec     measurement time for each step, default 5\n"
+	"\t-e keys    send burst every given keystrokes, 0 for none,\n"
+	"\t           default 20\n"
+	"\t-i ms      keystroke period in every session, default 100\n"
+	"\t-n list    session counts, default 1,10,100,1000\n"
+	"\n"
+	"Runs term-filter sessions over echo program for every count and\n"
+	"prints CSV: echo latencies are in us, CPU time in s, RSS in KiB,\n"
+	"and are summed over term-filter processes.\n";
+
+int main (int argc, char *argv[])
+{
+	struct load o = {
+		.interval = 100000, .burst = 512, .every = 20, .duration = 5,
+	};
+	const char *list = "1,10,100,1000";
+	char *end, **args;
+	int c, i, count;
+
+	while ((c = getopt (argc, argv, "+b:d:e:i:n:")) != -1)
+		switch (c) {
+		case 'b':
+			if ((o.burst = atoi (optarg)) <= 1 || o.burst > BURSTMAX)
+				goto usage;
+			break;
+		case 'd':
+			if ((o.duration = atoi (optarg)) <= 0)
+				goto usage;
+			break;
+		case 'e':
+			if ((o.every = atoi (optarg)) < 0)
+				goto usage;
+			break;
+		case 'i':
+			if ((o.interval = atoi (optarg) * 1000) <= 0)
+				goto usage;
+			break;
+		case 'n':
+			list = optarg;
+			break;
+		default:
+			goto usage;
+		}
+
+	/* term-filter [options] sh -c ECHOPROG */
+	if ((args = calloc (argc - optind + 5, sizeof (args[0]))) == NULL) {
+		perror ("term-load");
+		return 1;
+	}
+
+	args[0] = "term-filter";
+
+	for (i = optind, c = optind < argc ? 0 : 1; i < argc; ++i)
+		args[c++] = argv[i];
+
+	args[c++] = "sh";
+	args[c++] = "-c";
+	args[c++] = ECHOPROG;
+
+	o.argv = args;
+	raise_fd_limit ();
+
+	printf ("sessions,keys,key_p50_us,key_p99_us,key_max_us,"
+		"bursts,burst_p50_us,burst_p99_us,"
+		"cpu_s,rss_kib,threads,ctx_switches\n");
+
+	for (; *list != '\0'; list = end + (*end == ',')) {
+		if ((count = strtol (list, &end, 10)) <= 0 ||
+		    (*end != ',' && *end != '\0'))
+			goto usage;
+
+		if (load_run (&o, count) < count)
+			break;
+	}
+
+	free (args);
+	free (o.key.data);
+	free (o.paste.data);
+	return 0;
+usage:
+	fputs (usage, stderr);
+	return 1;
+}
@@ -0,0 +1,122 @@
+/*
+ * Terminal Session Replay
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <unistd.h>
+
+#include "record.h"
+
+static ssize_t safe_write (int fd, const void *buf, size_t count)
+{
+	ssize_t avail, n;
+	const char *p;
+
+	for (p = buf, avail = count; avail > 0; p += n, avail -= n) {
+		while ((n = write (fd, p, avail)) < 0 && errno == EINTR) {}
+
+		if (n < 0)
+			return n;
+	}
+
+	return count;
+}
+
+static void sleep_us (uint64_t us)
+{
+	struct timespec ts = { us / 1000000, us % 1000000 * 1000 };
+
+	while (nanosleep (&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+/* play frames after seek point in real time, keyframes are redundant */
+static int play (struct player *o, uint64_t time, struct buffer *b)
+{
+	struct rec_frame frame;
+
+	for (buffer_reset (b); player_next (o, &frame, b); buffer_reset (b)) {
+		if (frame.type != REC_DATA)
+			continue;
+
+		if (frame.time > time)
+			sleep_us (frame.time - time);
+
+		time = frame.time;
+
+		if (safe_write (1, b->data, b->len) != b->len)
+			return 0;
+	}
+
+	return 1;
+}
+
+static const char *usage =
+	"usage:\n"
+	"\tterm-replay [options] file\n"
+	"\n"
+	"options:\n"
+	"\t-n         show screen at start time only, do not play\n"
+	"\t-s sec     start time, default 0\n";
+
+int main (int argc, char *argv[])
+{
+	double start = 0;
+	int c, once = 0, ok;
+	struct player o;
+	struct buffer b;
+	uint64_t time;
+	FILE *f;
+
+	while ((c = getopt (argc, argv, "ns:")) != -1)
+		switch (c) {
+		case 'n':
+			once = 1;
+			break;
+		case 's':
+			if ((start = atof (optarg)) < 0)
+				goto usage;
+			break;
+		default:
+			goto usage;
+		}
+
+	if (optind + 1 != argc)
+		goto usage;
+
+	if ((f = fopen (argv[optind], "rb")) == NULL) {
+		perror (argv[optind]);
+		return 1;
+	}
+
+	if (!player_open (&o, f)) {
+		fprintf (stderr, "term-replay: %s: not a session record\n",
+			 argv[optind]);
+		fclose (f);
+		return 1;
+	}
+
+	buffer_init (&b);
+	time = start * 1000000;
+
+	ok = player_seek (&o, time, &b) &&
+	     safe_write (1, b.data, b.len) == b.len &&
+	     (once || play (&o, time, &b));
+
+	if (!ok)
+		perror ("cannot replay session");
+
+	buffer_fini (&b);
+	player_close (&o);
+	return !ok;
+usage:
+	fputs (usage, stderr);
+	return 1;
+}
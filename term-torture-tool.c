@@ -0,0 +1,256 @@
+/*
+ * Terminal Filter Adversarial Benchmark
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+
+#define BLOCK  65536
+#define MiB    (1024 * 1024)
+
+static char block[BLOCK];
+
+static void fill_text (void)
+{
+	static const char line[] = "The quick brown fox jumps over the lazy dog\n";
+	size_t i;
+
+	for (i = 0; i < BLOCK; ++i)
+		block[i] = line[i % (sizeof (line) - 1)];
+}
+
+static void fill_random (void)
+{
+	uint64_t x = 88172645463325252ull;
+	size_t i;
+
+	for (i = 0; i < BLOCK; ++i) {
+		x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+		block[i] = x >> 32;
+	}
+}
+
+static void fill (const char *s)
+{
+	size_t i, len = strlen (s);
+
+	for (i = 0; i < BLOCK; ++i)
+		block[i] = s[i % len];
+}
+
+/* many-parameter sequence terminated at block end */
+static void fill_params (void)
+{
+	fill ("1;");
+	memcpy (block, "\033[", 2);
+	block[BLOCK - 1] = 'm';
+}
+
+struct corpus {
+	const char *name, *head;	/* head is written once */
+	void (*fill) (void);
+	const char *pattern;
+};
+
+static const struct corpus cases[] = {
+	{ "text",   "",        fill_text },
+	{ "esc",    "",        NULL, "\033" },		/* ESC flood */
+	{ "csi",    "\033[",   NULL, "1;" },		/* endless CSI */
+	{ "params", "",        fill_params },
+	{ "osc",    "\033]0;", NULL, "title " },	/* endless OSC */
+	{ "broken", "",        NULL, "\033[12\377text" },
+	{ "random", "",        fill_random },
+	{ NULL }
+};
+
+static const struct corpus *find_case (const char *name, size_t len)
+{
+	const struct corpus *c;
+
+	for (c = cases; c->name != NULL; ++c)
+		if (strncmp (c->name, name, len) == 0 && c->name[len] == '\0')
+			return c;
+
+	return NULL;
+}
+
+static int generate (const struct corpus *c, long size)
+{
+	long n;
+
+	if (c->fill != NULL)
+		c->fill ();
+	else
+		fill (c->pattern);
+
+	if (fputs (c->head, stdout) == EOF)
+		return 0;
+
+	for (n = size * MiB / BLOCK; n > 0; --n)
+		if (fwrite (block, BLOCK, 1, stdout) != 1)
+			return 0;
+
+	return fflush (stdout) == 0;
+}
+
+static double clock_s (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* run term-filter over generator, print CSV row */
+static int run_case (char **argv, const struct corpus *c, long size)
+{
+	posix_spawn_file_actions_t fa;
+	char mib[32], **p;
+	struct rusage u;
+	double start, time;
+	int ret, status;
+	pid_t pid;
+
+	/* argv ends with: self -g case size */
+	for (p = argv; *p != NULL; ++p) {}
+
+	snprintf (mib, sizeof (mib), "%ld", size);
+	p[-2] = (char *) c->name;
+	p[-1] = mib;
+
+	posix_spawn_file_actions_init (&fa);
+	posix_spawn_file_actions_addopen (&fa, 0, "/dev/null", O_RDONLY, 0);
+	posix_spawn_file_actions_addopen (&fa, 1, "/dev/null", O_WRONLY, 0);
+
+	start = clock_s ();
+	ret = posix_spawnp (&pid, argv[0], &fa, NULL, argv, environ);
+	posix_spawn_file_actions_destroy (&fa);
+
+	if ((errno = ret) != 0 || wait4 (pid, &status, 0, &u) != pid)
+		return 0;
+
+	time = clock_s () - start;
+
+	/* max RSS covers generator too, it keeps one block only */
+	printf ("%s,%ld,%.3f,%.1f,%ld,%.3f,%d\n", c->name, size, time,
+		size * MiB / 1e6 / time, u.ru_maxrss,
+		u.ru_utime.tv_sec + u.ru_utime.tv_usec / 1e6 +
+		u.ru_stime.tv_sec + u.ru_stime.tv_usec / 1e6,
+		WIFEXITED (status) ? WEXITSTATUS (status) : -1);
+	fflush (stdout);
+	return 1;
+}
+
+static const char *usage =
+	"usage:\n"
+	"\tterm-torture [options] [term-filter [options]]\n"
+	"\n"
+	"options:\n"
+	"\t-c list    corpus cases, default text,esc,csi,params,osc,broken,\n"
+	"\t           random\n"
+	"\t-s list    stream sizes in MiB, default 16,64\n"
+	"\n"
+	"Runs term-filter over every adversarial stream and prints CSV: time\n"
+	"and CPU time in s, rate in MB/s of input, max RSS in KiB. Same rate\n"
+	"and RSS for every size mean linear time and bounded memory.\n";
+
+int main (int argc, char *argv[])
+{
+	const char *list = "text,esc,csi,params,osc,broken,random";
+	const char *sizes = "16,64";
+	const struct corpus *c;
+	char self[4096], *end, **args;
+	const char *s, *e;
+	long size;
+	int i, n, ok = 1;
+	ssize_t len;
+
+	if (argc == 4 && strcmp (argv[1], "-g") == 0) {
+		if ((c = find_case (argv[2], strlen (argv[2]))) == NULL ||
+		    (size = strtol (argv[3], &end, 10)) <= 0 || *end != '\0')
+			goto usage;
+
+		return !generate (c, size);
+	}
+
+	while ((i = getopt (argc, argv, "+c:s:")) != -1)
+		switch (i) {
+		case 'c':
+			list = optarg;
+			break;
+		case 's':
+			sizes = optarg;
+			break;
+		default:
+			goto usage;
+		}
+
+	if ((len = readlink ("/proc/self/exe", self, sizeof (self) - 1)) < 0) {
+		perror ("term-torture");
+		return 1;
+	}
+
+	self[len] = '\0';
+
+	/* term-filter [options] self -g case size */
+	if ((args = calloc (argc - optind + 6, sizeof (args[0]))) == NULL) {
+		perror ("term-torture");
+		return 1;
+	}
+
+	args[0] = "term-filter";
+
+	for (i = optind, n = optind < argc ? 0 : 1; i < argc; ++i)
+		args[n++] = argv[i];
+
+	args[n++] = self;
+	args[n++] = "-g";
+	args[n++] = "";
+	args[n++] = "";
+
+	printf ("case,mib,time_s,mb_s,maxrss_kib,cpu_s,status\n");
+
+	for (s = list; ok && *s != '\0'; s = e + (*e == ',')) {
+		e = s + strcspn (s, ",");
+
+		if ((c = find_case (s, e - s)) == NULL) {
+			free (args);
+			goto usage;
+		}
+
+		for (end = (char *) sizes; ok && *end != '\0';
+		     end += (*end == ',')) {
+			if ((size = strtol (end, &end, 10)) <= 0 ||
+			    (*end != ',' && *end != '\0')) {
+				free (args);
+				goto usage;
+			}
+
+			if (!(ok = run_case (args, c, size)))
+				perror ("cannot run term-filter");
+		}
+	}
+
+	free (args);
+	return !ok;
+usage:
+	fputs (usage, stderr);
+	return 1;
+}
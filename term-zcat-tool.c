@@ -0,0 +1,94 @@
+/*
+ * Compressed Log Reader
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logger.h"
+
+#define MAGIC_SIZE  (sizeof (LOG_MAGIC) - 1)
+
+static char in[LOG_CHUNK], out[LOG_CHUNK];
+
+static int copy (FILE *f, const char *head, size_t len)
+{
+	size_t n;
+
+	if (fwrite (head, 1, len, stdout) != len)
+		return 0;
+
+	while ((n = fread (in, 1, sizeof (in), f)) > 0)
+		if (fwrite (in, 1, n, stdout) != n)
+			return 0;
+
+	return !ferror (f);
+}
+
+static int unpack (FILE *f, const char *name)
+{
+	uint32_t head[2];
+	size_t n;
+
+	while (fread (head, sizeof (head), 1, f) == 1) {
+		if (head[0] > LOG_CHUNK || head[1] > head[0] ||
+		    fread (in, 1, head[1], f) != head[1])
+			goto broken;
+
+		if (head[1] == head[0])
+			n = fwrite (in, 1, head[0], stdout);
+		else if (lz_decompress (in, head[1], out, head[0]) == head[0])
+			n = fwrite (out, 1, head[0], stdout);
+		else
+			goto broken;
+
+		if (n != head[0])
+			return 0;
+	}
+
+	return !ferror (f);
+broken:
+	fprintf (stderr, "term-zcat: %s: broken frame\n", name);
+	return 0;
+}
+
+/* logs written without compression are copied as is */
+static int cat (FILE *f, const char *name)
+{
+	char head[MAGIC_SIZE];
+	size_t len = fread (head, 1, sizeof (head), f);
+
+	if (len == sizeof (head) && memcmp (head, LOG_MAGIC, len) == 0)
+		return unpack (f, name);
+
+	return copy (f, head, len);
+}
+
+int main (int argc, char *argv[])
+{
+	int i, ok = 1;
+	FILE *f;
+
+	if (argc < 2)
+		return !cat (stdin, "stdin");
+
+	for (i = 1; i < argc; ++i) {
+		if ((f = fopen (argv[i], "rb")) == NULL) {
+			perror (argv[i]);
+			ok = 0;
+			continue;
+		}
+
+		if (!cat (f, argv[i]))
+			ok = 0;
+
+		fclose (f);
+	}
+
+	return !ok;
+}
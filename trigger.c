@@ -0,0 +1,440 @@
+/*
+ * Output Triggers
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "trigger.h"
+
+static long long trigger_clock (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+/* Rules parser */
+
+static int hex (int c)
+{
+	return c >= '0' && c <= '9' ? c - '0' :
+	       c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+	       c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+}
+
+static int unescape (const char **p, char **q)
+{
+	int c = *(*p)++, h, l;
+
+	switch (c) {
+	case 'e':	c = 033;  break;
+	case 'n':	c = '\n'; break;
+	case 'r':	c = '\r'; break;
+	case 't':	c = '\t'; break;
+	case '\\':
+	case '"':	break;
+	case 'x':
+		if ((h = hex ((*p)[0])) < 0 || (l = hex ((*p)[1])) < 0)
+			return 0;
+
+		c = h << 4 | l;
+		*p += 2;
+		break;
+	default:
+		return 0;
+	}
+
+	*(*q)++ = c;
+	return 1;
+}
+
+/*
+ * Cut next word from line, unquoting it in place. Returns zero at end
+ * of line or on wrong word, word is NULL in the first case.
+ */
+static int get_word (char **line, char **word, size_t *len)
+{
+	const char *p = *line;
+	char *q;
+	int quote;
+
+	for (; *p == ' ' || *p == '\t'; ++p) {}
+
+	if (*p == '\0' || *p == '\n' || *p == '\r') {
+		*word = NULL;
+		return 0;
+	}
+
+	*word = q = *line = (char *) p;
+
+	if ((quote = *p) == '\'' || quote == '"')
+		for (++p; *p != quote; )
+			if (*p == '\0')
+				return 0;
+			else if (quote == '"' && *p == '\\') {
+				if (++p, !unescape (&p, &q))
+					return 0;
+			}
+			else
+				*q++ = *p++;
+	else
+		for (; *p != '\0' && *p != ' ' && *p != '\t' && *p != '\n' &&
+		       *p != '\r'; )
+			*q++ = *p++;
+
+	*len  = q - *word;
+	*line = (char *) p + (quote == '\'' || quote == '"');
+	return 1;
+}
+
+static int get_rule (char **line, struct trigger_rule *r)
+{
+	char *word;
+	size_t len;
+
+	if (!get_word (line, &word, &len))
+		return 0;
+
+	if (strncmp (word, "send", len) == 0 && len == 4)
+		r->action = TRIGGER_SEND;
+	else if (strncmp (word, "run", len) == 0 && len == 3)
+		r->action = TRIGGER_RUN;
+	else
+		return 0;
+
+	if (!get_word (line, &word, &len) ||
+	    (r->action == TRIGGER_RUN && memchr (word, '\0', len) != NULL) ||
+	    (r->arg = malloc (len + 1)) == NULL)
+		return 0;
+
+	memcpy (r->arg, word, len);
+	r->arg[len] = '\0';
+	r->len = len;
+
+	if (get_word (line, &word, &len) || word != NULL) {
+		free (r->arg);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int add_rule (struct trigger_rule **v, size_t count,
+		     const struct trigger_rule *r)
+{
+	struct trigger_rule *p;
+
+	if ((p = realloc (*v, (count + 1) * sizeof (p[0]))) == NULL)
+		return 0;
+
+	p[count] = *r;
+	*v = p;
+	return 1;
+}
+
+static int parse_line (struct trigger *o, char *line)
+{
+	struct trigger_rule r = {};
+	char *verb, *pattern, *next, num[32], *end;
+	size_t len, plen;
+
+	if (!get_word (&line, &verb, &len))
+		return verb == NULL;
+
+	if (verb[0] == '#')
+		return 1;
+
+	if (strncmp (verb, "on", len) == 0 && len == 2) {
+		if (!get_word (&line, &pattern, &plen))
+			return 0;
+
+		next = line;
+
+		if (get_word (&next, &verb, &len) &&
+		    strncmp (verb, "once", len) == 0 && len == 4) {
+			r.once = 1;
+			line = next;
+		}
+
+		if (!get_rule (&line, &r))
+			return 0;
+
+		/* rule is added first, thus every pattern has its rule */
+		if (add_rule (&o->rule, o->m.patterns, &r) &&
+		    match_add (&o->m, pattern, plen))
+			return 1;
+
+		free (r.arg);
+		return 0;
+	}
+
+	if (strncmp (verb, "timeout", len) == 0 && len == 7) {
+		if (!get_word (&line, &verb, &len) || len >= sizeof (num))
+			return 0;
+
+		memcpy (num, verb, len);
+		num[len] = '\0';
+		r.timeout = strtod (num, &end) * 1000;
+
+		if (*end != '\0' || r.timeout <= 0 || r.timeout > 86400000 ||
+		    !get_rule (&line, &r))
+			return 0;
+
+		if (add_rule (&o->timer, o->count, &r)) {
+			++o->count;
+			return 1;
+		}
+
+		free (r.arg);
+		return 0;
+	}
+
+	return 0;
+}
+
+static int load (struct trigger *o, const char *path)
+{
+	char *line = NULL;
+	size_t size = 0;
+	FILE *f;
+	int ok, e = 0;
+
+	if ((f = fopen (path, "r")) == NULL)
+		return 0;
+
+	for (o->line = 1; getline (&line, &size, f) >= 0; ++o->line)
+		if (!parse_line (o, line)) {
+			e = errno == ENOMEM ? ENOMEM : EINVAL;
+			break;
+		}
+
+	ok = e == 0 && feof (f) && !ferror (f);
+	free (line);
+	fclose (f);
+
+	if (e != 0)
+		errno = e;
+
+	return ok;
+}
+
+int trigger_init (struct trigger *o, const char *path)
+{
+	match_init (&o->m);
+	o->rule  = o->timer = NULL;
+	o->count = 0;
+	o->last  = trigger_clock ();
+	o->hit   = NULL;
+	o->nhits = o->hsize = 0;
+	o->pid   = NULL;
+	o->npids = o->psize = 0;
+
+	errno = 0;
+
+	if (load (o, path) && match_compile (&o->m))
+		return 1;
+
+	trigger_fini (o);
+	return 0;
+}
+
+static void reap (struct trigger *o)
+{
+	size_t i;
+
+	for (i = 0; i < o->npids;)
+		if (waitpid (o->pid[i], NULL, WNOHANG) != 0)
+			o->pid[i] = o->pid[--o->npids];
+		else
+			++i;
+}
+
+void trigger_fini (struct trigger *o)
+{
+	size_t i;
+
+	reap (o);
+
+	for (i = 0; i < o->m.patterns; ++i)
+		free (o->rule[i].arg);
+
+	for (i = 0; i < o->count; ++i)
+		free (o->timer[i].arg);
+
+	match_fini (&o->m);
+	free (o->rule);
+	free (o->timer);
+	free (o->hit);
+	free (o->pid);
+}
+
+/* Actions */
+
+/* command gets no terminal input, relay threads block signals */
+static int run_command (struct trigger *o, const char *command)
+{
+	char *argv[] = { "sh", "-c", (char *) command, NULL };
+	posix_spawn_file_actions_t fa;
+	posix_spawnattr_t sa;
+	pid_t pid, *p;
+	sigset_t none;
+	size_t size;
+	int ret;
+
+	if (o->npids == o->psize) {
+		size = o->psize * 2 + 8;
+
+		if ((p = realloc (o->pid, size * sizeof (p[0]))) == NULL)
+			return 0;
+
+		o->pid   = p;
+		o->psize = size;
+	}
+
+	sigemptyset (&none);
+
+	if ((ret = posix_spawn_file_actions_init (&fa)) != 0)
+		goto no_actions;
+
+	if ((ret = posix_spawnattr_init (&sa)) != 0)
+		goto no_attr;
+
+	if ((ret = posix_spawnattr_setflags (&sa, POSIX_SPAWN_SETSIGMASK)) != 0 ||
+	    (ret = posix_spawnattr_setsigmask (&sa, &none)) != 0 ||
+	    (ret = posix_spawn_file_actions_addopen (&fa, 0, "/dev/null",
+						      O_RDONLY, 0)) != 0)
+		goto no_spawn;
+
+	if ((ret = posix_spawn (&pid, "/bin/sh", &fa, &sa, argv, environ)) == 0)
+		o->pid[o->npids++] = pid;
+no_spawn:
+	posix_spawnattr_destroy (&sa);
+no_attr:
+	posix_spawn_file_actions_destroy (&fa);
+no_actions:
+	errno = ret;
+	return ret == 0;
+}
+
+static int fire (struct trigger *o, struct trigger_rule *r,
+		 struct buffer *out)
+{
+	r->fired = 1;
+
+	if (r->action == TRIGGER_SEND)
+		return buffer_add (out, r->arg, r->len);
+
+	reap (o);
+	return run_command (o, r->arg);
+}
+
+/* Matching */
+
+static void add_hit (void *ctx, size_t id, size_t end)
+{
+	struct trigger *o = ctx;
+	struct trigger_hit *p;
+	size_t size;
+
+	if (o->nhits == o->hsize) {
+		size = o->hsize * 2 + 16;
+
+		if ((p = realloc (o->hit, size * sizeof (p[0]))) == NULL)
+			return;		/* drop hit rather than relay */
+
+		o->hit   = p;
+		o->hsize = size;
+	}
+
+	o->hit[o->nhits].end = end;
+	o->hit[o->nhits].id  = id;
+	++o->nhits;
+}
+
+static int hit_cmp (const void *a, const void *b)
+{
+	const struct trigger_hit *p = a, *q = b;
+
+	return p->end != q->end ? (p->end > q->end) - (p->end < q->end) :
+				  (p->id  > q->id)  - (p->id  < q->id);
+}
+
+int trigger_tick (struct trigger *o, struct buffer *out)
+{
+	long long now = trigger_clock ();
+	struct trigger_rule *r;
+	int ok = 1;
+
+	for (r = o->timer; r < o->timer + o->count; ++r)
+		if (!r->fired && now - o->last >= r->timeout)
+			ok &= fire (o, r, out);
+
+	return ok;
+}
+
+int trigger_write (struct trigger *o, const char *data, size_t len,
+		   struct buffer *out)
+{
+	struct trigger_rule *r;
+	size_t i;
+	int ok = 1;
+
+	o->nhits = 0;
+	match_run (&o->m, data, len, add_hit, o);
+
+	/* automata report in turn, fire in output order */
+	if (o->m.count + (o->m.nfa.words > 0) > 1)
+		qsort (o->hit, o->nhits, sizeof (o->hit[0]), hit_cmp);
+
+	for (i = 0; i < o->nhits; ++i) {
+		r = o->rule + o->hit[i].id;
+
+		if (r->once && r->fired)
+			continue;
+
+		ok &= fire (o, r, out);
+		o->last = trigger_clock ();
+
+		for (r = o->timer; r < o->timer + o->count; ++r)
+			r->fired = 0;
+	}
+
+	/* output may go on without matches */
+	return trigger_tick (o, out) && ok;
+}
+
+int trigger_wait (struct trigger *o)
+{
+	long long now = trigger_clock (), wait = -1, t;
+	size_t i;
+
+	for (i = 0; i < o->count; ++i) {
+		if (o->timer[i].fired)
+			continue;
+
+		if ((t = o->last + o->timer[i].timeout - now) < 0)
+			t = 0;
+
+		if (wait < 0 || t < wait)
+			wait = t;
+	}
+
+	return wait;
+}
@@ -0,0 +1,78 @@
+/*
+ * Output Triggers
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef TRIGGER_H
+#define TRIGGER_H  1
+
+#include <stddef.h>
+
+#include <sys/types.h>
+
+#include "buffer.h"
+#include "match.h"
+
+enum trigger_action { TRIGGER_SEND, TRIGGER_RUN };
+
+struct trigger_rule {
+	int action;
+	int once, fired;
+	long timeout;			/* ms, zero for pattern rule */
+	char *arg;			/* text to send or shell command */
+	size_t len;
+};
+
+struct trigger_hit {
+	size_t end, id;
+};
+
+/*
+ * Rules file has a rule per line, empty lines and lines starting with #
+ * are skipped:
+ *
+ *	on pattern [once] send text
+ *	on pattern [once] run command
+ *	timeout sec send text
+ *	timeout sec run command
+ *
+ * Pattern rule fires every time output matches pattern (see match.h),
+ * or only the first time with once. Timeout rule fires once when no
+ * pattern rule has fired for given time, next match arms it again. Text
+ * is appended to output buffer to be sent to program as is, command is
+ * run by shell in background.
+ *
+ * Words are separated by spaces, quote them with '' to keep spaces, or
+ * with "" to use escapes \e \n \r \t \\ \" and \xHH.
+ */
+struct trigger {
+	struct match m;
+	struct trigger_rule *rule;	/* by pattern */
+	struct trigger_rule *timer;
+	size_t count;			/* of timers */
+	long long last;			/* time of last match, ms */
+	struct trigger_hit *hit;
+	size_t nhits, hsize;
+	pid_t *pid;			/* commands not reaped yet */
+	size_t npids, psize;
+	int line;			/* of rule error */
+};
+
+/* returns zero on failure, errno is EINVAL for wrong rule at line */
+int  trigger_init (struct trigger *o, const char *path);
+void trigger_fini (struct trigger *o);
+
+/* match next chunk of output and fire rules, text is appended to out */
+int trigger_write (struct trigger *o, const char *data, size_t len,
+		   struct buffer *out);
+
+/* returns ms until next timeout rule fires, or -1 if none armed */
+int trigger_wait (struct trigger *o);
+
+/* fire expired timeout rules */
+int trigger_tick (struct trigger *o, struct buffer *out);
+
+#endif  /* TRIGGER_H */
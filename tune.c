@@ -0,0 +1,94 @@
+/*
+ * Thread Scheduling Tuning
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+
+#include <sys/resource.h>
+
+#include <sched.h>
+
+#include "tune.h"
+
+static int get_cpu (const char **s, unsigned *cpu)
+{
+	char *end;
+	unsigned long x;
+
+	if (**s < '0' || **s > '9')
+		return 0;
+
+	x = strtoul (*s, &end, 10);
+
+	if (x >= TUNE_MAX_CPUS)
+		return 0;
+
+	*s   = end;
+	*cpu = x;
+	return 1;
+}
+
+int tune_cpus (struct tune *o, const char *s)
+{
+	unsigned from, to;
+
+	do {
+		if (!get_cpu (&s, &from))
+			return 0;
+
+		to = from;
+
+		if (*s == '-' && (++s, !get_cpu (&s, &to) || to < from))
+			return 0;
+
+		for (; from <= to; ++from)
+			o->cpus[from / 64] |= 1ULL << (from % 64);
+	}
+	while (*s++ == ',');
+
+	return s[-1] == '\0';
+}
+
+static int has_cpus (const struct tune *o)
+{
+	int i;
+
+	for (i = 0; i < TUNE_MAX_CPUS / 64; ++i)
+		if (o->cpus[i] != 0)
+			return 1;
+
+	return 0;
+}
+
+/* on Linux zero pid means calling thread for all three calls */
+int tune_apply (const struct tune *o)
+{
+	struct sched_param sp = { .sched_priority = o->fifo };
+	cpu_set_t set;
+	int i;
+
+	if (has_cpus (o)) {
+		CPU_ZERO (&set);
+
+		for (i = 0; i < TUNE_MAX_CPUS; ++i)
+			if ((o->cpus[i / 64] & (1ULL << (i % 64))) != 0)
+				CPU_SET (i, &set);
+
+		if (sched_setaffinity (0, sizeof (set), &set) != 0)
+			return 0;
+	}
+
+	if (o->nice != 0 && setpriority (PRIO_PROCESS, 0, o->nice) != 0)
+		return 0;
+
+	if (o->fifo > 0 && sched_setscheduler (0, SCHED_FIFO, &sp) != 0)
+		return 0;
+
+	return 1;
+}
@@ -0,0 +1,36 @@
+/*
+ * Thread Scheduling Tuning
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef TUNE_H
+#define TUNE_H  1
+
+#include <stdint.h>
+
+#define TUNE_MAX_CPUS  1024
+
+struct tune {
+	uint64_t cpus[TUNE_MAX_CPUS / 64];	/* empty set: do not pin */
+	int fifo;				/* SCHED_FIFO priority or 0 */
+	int nice;
+};
+
+static inline void tune_init (struct tune *o)
+{
+	*o = (struct tune) {};
+}
+
+/* add CPU list like 0,2-3 to affinity set, returns zero on syntax error */
+int tune_cpus (struct tune *o, const char *list);
+
+/*
+ * Apply settings to calling thread, threads created later inherit them.
+ * Returns zero and sets errno on failure.
+ */
+int tune_apply (const struct tune *o);
+
+#endif  /* TUNE_H */
@@ -0,0 +1,155 @@
+/*
+ * UTF-8 Validation Stage
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "utf8.h"
+
+static const char replacement[] = "\xef\xbf\xbd";
+
+/*
+ * Skip ASCII prefix: up to 64 bytes per step with SSE2, word at a time
+ * otherwise, the rest is done byte by byte
+ */
+static const unsigned char *
+skip_ascii (const unsigned char *p, const unsigned char *end)
+{
+	uint64_t w;
+#ifdef __SSE2__
+	__m128i a, b, c, d;
+	int mask;
+
+	for (; end - p >= 64; p += 64) {
+		a = _mm_loadu_si128 ((const void *) p);
+		b = _mm_loadu_si128 ((const void *) (p + 16));
+		c = _mm_loadu_si128 ((const void *) (p + 32));
+		d = _mm_loadu_si128 ((const void *) (p + 48));
+
+		if (_mm_movemask_epi8 (_mm_or_si128 (_mm_or_si128 (a, b),
+						     _mm_or_si128 (c, d))) != 0)
+			break;
+	}
+
+	for (; end - p >= 16; p += 16) {
+		mask = _mm_movemask_epi8 (_mm_loadu_si128 ((const void *) p));
+
+		if (mask != 0)
+			return p + __builtin_ctz (mask);
+	}
+#endif
+	for (; end - p >= 8; p += 8) {
+		memcpy (&w, p, sizeof (w));
+
+		if ((w & 0x8080808080808080ULL) != 0)
+			break;
+	}
+
+	for (; p < end && *p < 0x80; ++p) {}
+
+	return p;
+}
+
+/*
+ * Check sequence starting with non-ASCII byte. Returns length of valid
+ * character, zero if valid prefix is cut by the end of data, or negated
+ * length of ill-formed subsequence to replace.
+ */
+static int check (const unsigned char *p, const unsigned char *end)
+{
+	int c = *p, n, lo = 0x80, hi = 0xbf, i;
+
+	if (c >= 0xc2 && c <= 0xdf)
+		n = 2;
+	else if (c >= 0xe0 && c <= 0xef) {
+		n = 3;
+		lo = c == 0xe0 ? 0xa0 : lo;	/* overlong */
+		hi = c == 0xed ? 0x9f : hi;	/* surrogates */
+	}
+	else if (c >= 0xf0 && c <= 0xf4) {
+		n = 4;
+		lo = c == 0xf0 ? 0x90 : lo;	/* overlong */
+		hi = c == 0xf4 ? 0x8f : hi;	/* above U+10FFFF */
+	}
+	else
+		return -1;
+
+	for (i = 1; i < n; ++i, lo = 0x80, hi = 0xbf) {
+		if (p + i == end)
+			return 0;
+
+		if (p[i] < lo || p[i] > hi)
+			return -i;
+	}
+
+	return n;
+}
+
+/* complete sequence kept from previous chunk, consumed bytes skipped */
+static int complete (struct utf8_filter *o, const unsigned char **p,
+		     const unsigned char *end, struct buffer *out)
+{
+	int n;
+
+	for (; *p < end; ++*p) {
+		o->tail[o->len++] = **p;
+
+		if ((n = check (o->tail, o->tail + o->len)) > 0) {
+			o->len = 0;
+			++*p;
+			return buffer_add (out, o->tail, n);
+		}
+
+		if (n < 0) {	/* this byte is not a part of sequence */
+			o->len = 0;
+			return buffer_add (out, replacement, 3);
+		}
+	}
+
+	return 1;
+}
+
+int utf8_write (struct utf8_filter *o, const char *data, size_t len,
+		struct buffer *out)
+{
+	const unsigned char *p = (const void *) data, *end = p + len, *run;
+	int n;
+
+	if (o->len > 0 && !complete (o, &p, end, out))
+		return 0;
+
+	for (run = p; (p = skip_ascii (p, end)) < end; )
+		if ((n = check (p, end)) > 0)
+			p += n;
+		else if (n < 0) {
+			if (!buffer_add (out, run, p - run) ||
+			    !buffer_add (out, replacement, 3))
+				return 0;
+
+			run = p -= n;
+		}
+		else {
+			o->len = end - p;
+			memcpy (o->tail, p, o->len);
+			end = p;
+		}
+
+	return buffer_add (out, run, p - run);
+}
+
+int utf8_flush (struct utf8_filter *o, struct buffer *out)
+{
+	if (o->len == 0)
+		return 1;
+
+	o->len = 0;
+	return buffer_add (out, replacement, 3);
+}
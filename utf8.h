@@ -0,0 +1,36 @@
+/*
+ * UTF-8 Validation Stage
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef UTF8_H
+#define UTF8_H  1
+
+#include "buffer.h"
+
+/*
+ * Every maximal ill-formed subsequence is replaced with U+FFFD, an
+ * incomplete sequence at the end of chunk is kept until the next one,
+ * thus no output chunk splits a character.
+ */
+struct utf8_filter {
+	int len;
+	unsigned char tail[4];
+};
+
+static inline void utf8_init (struct utf8_filter *o)
+{
+	o->len = 0;
+}
+
+/* validate next chunk and append result to buffer, zero on out of memory */
+int utf8_write (struct utf8_filter *o, const char *data, size_t len,
+		struct buffer *out);
+
+/* append replacement for incomplete sequence at end of stream if any */
+int utf8_flush (struct utf8_filter *o, struct buffer *out);
+
+#endif  /* UTF8_H */
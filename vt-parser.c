@@ -0,0 +1,248 @@
+/*
+ * VT Escape Sequence Parser
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "vt-parser.h"
+
+enum vt_state {
+	GROUND, ESCAPE, ESCAPE_INTER,
+	CSI_PARAM, CSI_INTER, CSI_IGNORE,
+	STRING, STRING_ESC,
+};
+
+struct vt_limits vt_limits = { VT_SEQ_LEN, VT_STRING_LEN, VT_PARAMS };
+
+void vt_parser_init (struct vt_parser *o, const struct vt_ops *ops,
+		     void *cookie)
+{
+	o->ops    = ops;
+	o->cookie = cookie;
+	o->state  = GROUND;
+	o->limits = vt_limits;
+
+	if (o->limits.params > VT_MAX_PARAMS)
+		o->limits.params = VT_MAX_PARAMS;
+}
+
+static void seq_reset (struct vt_seq *s)
+{
+	s->final   = 0;
+	s->mark    = 0;
+	s->ninter  = 0;
+	s->nparams = 0;
+}
+
+static int seq_inter (struct vt_seq *s, int c)
+{
+	if (s->ninter >= VT_MAX_INTER)
+		return 0;
+
+	s->inter[s->ninter++] = c;
+	return 1;
+}
+
+static int seq_digit (struct vt_seq *s, int c)
+{
+	int *p;
+
+	if (s->nparams == 0)
+		s->param[s->nparams++] = -1;
+
+	p = s->param + s->nparams - 1;
+
+	if (*p < 0)
+		*p = 0;
+
+	if (*p < 10000)
+		*p = *p * 10 + (c - '0');
+
+	return 1;
+}
+
+static int seq_next (struct vt_seq *s, int max)
+{
+	if (s->nparams == 0)
+		s->param[s->nparams++] = -1;
+
+	if (s->nparams >= max)
+		return 0;
+
+	s->param[s->nparams++] = -1;
+	return 1;
+}
+
+static void seq_start (struct vt_parser *o)
+{
+	seq_reset (&o->seq);
+	o->len   = 0;
+	o->state = ESCAPE;
+}
+
+static void execute (struct vt_parser *o, int c)
+{
+	if (o->ops->execute != NULL)
+		o->ops->execute (o->cookie, c);
+}
+
+static void esc_dispatch (struct vt_parser *o, int c)
+{
+	o->seq.final = c;
+	o->state = GROUND;
+
+	if (o->ops->esc != NULL)
+		o->ops->esc (o->cookie, &o->seq);
+}
+
+static void csi_dispatch (struct vt_parser *o, int c)
+{
+	o->seq.final = c;
+	o->state = GROUND;
+
+	if (o->ops->csi != NULL)
+		o->ops->csi (o->cookie, &o->seq);
+}
+
+/* returns zero if sequence is dropped and byte belongs to ground */
+static int vt_step (struct vt_parser *o, int c)
+{
+	int string = o->state == STRING || o->state == STRING_ESC;
+
+	if (c == 030 || c == 032) {		/* CAN, SUB */
+		o->state = GROUND;
+		return 1;
+	}
+
+	if (c == 033 && o->state != STRING) {
+		seq_start (o);
+		return 1;
+	}
+
+	if (++o->len > (string ? o->limits.string : o->limits.seq) ||
+	    (c > 0177 && !string)) {
+		o->state = GROUND;
+		return 0;
+	}
+
+	switch (o->state) {
+	case ESCAPE:
+	case ESCAPE_INTER:
+		if (c < 040)
+			execute (o, c);
+		else if (c < 060)
+			o->state = seq_inter (&o->seq, c) ? ESCAPE_INTER :
+							    GROUND;
+		else if (c == 0177)
+			break;
+		else if (o->state == ESCAPE_INTER)
+			esc_dispatch (o, c);
+		else if (c == '[')
+			o->state = CSI_PARAM;
+		else if (c == ']' || c == 'P' || c == 'X' || c == '^' ||
+			 c == '_')
+			o->state = STRING;	/* OSC, DCS, SOS, PM, APC */
+		else
+			esc_dispatch (o, c);
+		break;
+
+	case CSI_PARAM:
+		if (c >= '0' && c <= '9')
+			seq_digit (&o->seq, c);
+		else if (c == ';' || c == ':') {
+			if (!seq_next (&o->seq, o->limits.params))
+				o->state = CSI_IGNORE;
+		}
+		else if (c >= 074 && c <= 077) {
+			if (o->seq.nparams == 0 && o->seq.mark == 0)
+				o->seq.mark = c;
+			else
+				o->state = CSI_IGNORE;
+		}
+		else if (c >= 040 && c < 060)
+			o->state = seq_inter (&o->seq, c) ? CSI_INTER :
+							    CSI_IGNORE;
+		else if (c >= 0100 && c <= 0176)
+			csi_dispatch (o, c);
+		else if (c < 040)
+			execute (o, c);
+		break;
+
+	case CSI_INTER:
+		if (c >= 040 && c < 060) {
+			if (!seq_inter (&o->seq, c))
+				o->state = CSI_IGNORE;
+		}
+		else if (c >= 060 && c < 0100)
+			o->state = CSI_IGNORE;
+		else if (c >= 0100 && c <= 0176)
+			csi_dispatch (o, c);
+		else if (c < 040)
+			execute (o, c);
+		break;
+
+	case CSI_IGNORE:
+		if (c >= 0100 && c <= 0176)
+			o->state = GROUND;
+		else if (c < 040)
+			execute (o, c);
+		break;
+
+	case STRING:
+		if (c == 007)			/* BEL terminates OSC */
+			o->state = GROUND;
+		else if (c == 033)
+			o->state = STRING_ESC;
+		break;
+
+	case STRING_ESC:
+		seq_start (o);
+
+		if (c == '\\')			/* ST */
+			o->state = GROUND;
+		else
+			return vt_step (o, c);
+		break;
+	}
+
+	return 1;
+}
+
+static int is_print (int c)
+{
+	return c >= 040 && c != 0177;
+}
+
+void vt_parser_write (struct vt_parser *o, const char *data, size_t len)
+{
+	const unsigned char *p = (const void *) data, *end = p + len, *q;
+
+	while (p < end) {
+		if (o->state != GROUND) {
+			p += vt_step (o, *p);
+			continue;
+		}
+
+		for (q = p; q < end && is_print (*q); ++q) {}
+
+		if (q > p && o->ops->print != NULL)
+			o->ops->print (o->cookie, (const char *) p, q - p);
+
+		if (q == end)
+			break;
+
+		if (*q == 033)
+			seq_start (o);
+		else if (*q != 0177)
+			execute (o, *q);
+
+		p = q + 1;
+	}
+}
+
+int vt_parser_ground (const struct vt_parser *o)
+{
+	return o->state == GROUND;
+}
@@ -0,0 +1,79 @@
+/*
+ * VT Escape Sequence Parser
+ *
+ * Copyright (c) 2019-2026 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef VT_PARSER_H
+#define VT_PARSER_H  1
+
+#include <stddef.h>
+
+#define VT_MAX_PARAMS	32
+#define VT_MAX_INTER	2
+
+#define VT_SEQ_LEN	256		/* default limits */
+#define VT_STRING_LEN	65536
+#define VT_PARAMS	16
+
+/*
+ * Sequence longer than seq bytes, string longer than string bytes, and
+ * sequence with byte above 0x7f are dropped: parser goes back to ground
+ * at the offending byte, thus the rest of garbage is shown as text, not
+ * swallowed. Sequence with more than params parameters is ignored up to
+ * its final byte.
+ */
+struct vt_limits {
+	size_t seq;			/* ESC or CSI sequence length */
+	size_t string;			/* OSC, DCS, SOS, PM or APC length */
+	int params;			/* up to VT_MAX_PARAMS */
+};
+
+/* limits for parsers initialized later */
+extern struct vt_limits vt_limits;
+
+struct vt_seq {
+	int final;			/* final character */
+	int mark;			/* private marker: < = > ? or zero */
+	int ninter;
+	char inter[VT_MAX_INTER];	/* intermediate characters */
+	int nparams;
+	int param[VT_MAX_PARAMS];	/* -1 for omitted parameter */
+};
+
+static inline int vt_param (const struct vt_seq *s, int i, int def)
+{
+	return i < s->nparams && s->param[i] > 0 ? s->param[i] : def;
+}
+
+/*
+ * Any callback may be NULL. Printable text (including UTF-8 bytes) is
+ * passed to print in runs as large as possible, so no run crosses the
+ * chunk boundary, but one character can be split between two runs.
+ */
+struct vt_ops {
+	void (*print)   (void *cookie, const char *text, size_t len);
+	void (*execute) (void *cookie, int c);
+	void (*esc)     (void *cookie, const struct vt_seq *s);
+	void (*csi)     (void *cookie, const struct vt_seq *s);
+};
+
+struct vt_parser {
+	const struct vt_ops *ops;
+	void *cookie;
+	int state;
+	struct vt_seq seq;
+	struct vt_limits limits;
+	size_t len;			/* of current sequence or string */
+};
+
+void vt_parser_init (struct vt_parser *o, const struct vt_ops *ops,
+		     void *cookie);
+void vt_parser_write (struct vt_parser *o, const char *data, size_t len);
+
+/* returns non-zero if parser is not inside of sequence or string */
+int vt_parser_ground (const struct vt_parser *o);
+
+#endif  /* VT_PARSER_H */